@@ -1,5 +1,7 @@
 #include "BoundaryGraph.h"
 #include <algorithm>
+#include <cstdlib>
+#include <omp.h>
 
 bool Point::operator<(const Point &other) const {
     if (x != other.x)
@@ -181,6 +183,16 @@ std::vector<std::vector<Point>> BoundaryGraph::findCycles() {
         return results;
 
     Point start = adj.begin()->first;
+
+    // 8x8 のドット絵の境界なら密な表現で探索する
+    if (buildDense()) {
+        std::vector<DenseCycle> cycles;
+        findDenseCycles(-1, cycles);
+        for (const auto &cycle : cycles)
+            results.push_back(toPoints(cycle.path));
+        return results;
+    }
+
     path.push_back(start);
 
     backtrack(start, path, visited, results);
@@ -188,10 +200,127 @@ std::vector<std::vector<Point>> BoundaryGraph::findCycles() {
 }
 
 std::vector<std::vector<Point>> BoundaryGraph::findClockwiseCycles() {
+    return enumerateClockwiseCycles(false);
+}
+
+std::vector<std::vector<Point>> BoundaryGraph::findFeasibleClockwiseCycles() {
+    return enumerateClockwiseCycles(true);
+}
+
+std::vector<PackedLoop> BoundaryGraph::findFeasibleClockwiseLoops() {
+    std::vector<PackedLoop> loops;
+    for (const auto &cycle : findFeasibleClockwiseCycles()) {
+        std::vector<int> nodes;
+        for (const auto &p : cycle)
+            nodes.push_back(p.y * 9 + p.x);
+        PackedLoop loop;
+        if (PackedLoop::pack(nodes, loop))
+            loops.push_back(loop);
+    }
+    return loops;
+}
+
+void BoundaryGraph::streamFeasibleClockwiseLoops(
+    const std::function<bool(const PackedLoop &)> &visit) {
+    // 32辺でなければ PackedLoop にならない
+    if (adj.empty() || total_edges != 32)
+        return;
+
+    // enumerateClockwiseCycles と同じく、最初に右へ進むサイクルだけを探索し、
+    // 反時計回りだったものは向きを反転してから渡す
+    prune_distance = true;
+    if (buildDense()) {
+        Point start = adj.begin()->first;
+        int s = start.x * GRID + start.y;
+        if (dense_degree[s] == 2) {
+            DenseSink sink = [&](const std::vector<int> &path, int turn) {
+                if (turn == 0)
+                    return true;
+                std::vector<int> nodes;
+                for (int v : path)
+                    nodes.push_back((v % GRID) * 9 + v / GRID);
+                if (turn < 0)
+                    std::reverse(nodes.begin(), nodes.end());
+                PackedLoop loop;
+                if (!PackedLoop::pack(nodes, loop))
+                    return true;
+                return visit(loop);
+            };
+            std::vector<DenseCycle> unused;
+            findDenseCycles(dense_next[s][0], unused, &sink);
+            prune_distance = false;
+            return;
+        }
+    }
+    prune_distance = false;
+
+    for (const auto &loop : findFeasibleClockwiseLoops()) {
+        if (!visit(loop))
+            return;
+    }
+}
+
+// サイクルに距離条件を満たすズラシが1つでもあるか
+bool BoundaryGraph::hasFeasibleSlide(const std::vector<Point> &cycle) const {
+    if (cycle.size() < 32)
+        return false;
+    int xs[32], ys[32];
+    unsigned int slides = ALL_SLIDES;
+    for (int pos = 0; pos < 32 && slides != 0; pos++) {
+        xs[pos] = cycle[pos].x;
+        ys[pos] = cycle[pos].y;
+        slides = update_slides(slides, pos, xs, ys);
+    }
+    return slides != 0;
+}
+
+std::vector<std::vector<Point>>
+BoundaryGraph::enumerateClockwiseCycles(bool distance) {
+    // 距離条件は32辺のループにだけ定義されている
+    prune_distance = distance && total_edges == 32;
+
+    // 始点は最も左上の頂点なので、右と下の2本の辺だけを持つ
+    // 逆向きのサイクルは最初の辺が入れ替わるので、最初に右へ進むものだけを
+    // 探索し、反時計回りだったものは向きを反転する
+    // 反転するとズラシ j は 8 - j に対応するので、距離条件での枝刈りも変わらない
+    if (!adj.empty() && buildDense()) {
+        Point start = adj.begin()->first;
+        int s = start.x * GRID + start.y;
+        if (dense_degree[s] == 2) {
+            std::vector<DenseCycle> cycles;
+            findDenseCycles(dense_next[s][0], cycles);
+            prune_distance = false;
+
+            std::vector<std::vector<int>> cw_paths;
+            for (auto &cycle : cycles) {
+                if (cycle.turn > 0) {
+                    cw_paths.push_back(cycle.path);
+                } else if (cycle.turn < 0) {
+                    std::reverse(cycle.path.begin(), cycle.path.end());
+                    cw_paths.push_back(cycle.path);
+                }
+            }
+
+            // findCycles と同じ順（各頂点で選んだ隣接頂点の番号の辞書順）に並べる
+            std::vector<std::pair<std::vector<int>, int>> order;
+            for (int i = 0; i < (int)cw_paths.size(); i++)
+                order.push_back({getChoices(cw_paths[i]), i});
+            std::sort(order.begin(), order.end());
+
+            std::vector<std::vector<Point>> cw_cycles;
+            for (const auto &o : order)
+                cw_cycles.push_back(toPoints(cw_paths[o.second]));
+            return cw_cycles;
+        }
+    }
+    prune_distance = false;
+
     std::vector<std::vector<Point>> all_cycles = findCycles();
     std::vector<std::vector<Point>> cw_cycles;
 
     for (const auto &cycle : all_cycles) {
+        if (distance && total_edges == 32 && !hasFeasibleSlide(cycle))
+            continue;
         std::vector<std::string> dirs = getPathDirections(cycle);
         if (determineDominantTurn(dirs) == "Clockwise") {
             cw_cycles.push_back(cycle);
@@ -227,4 +356,282 @@ void BoundaryGraph::backtrack(Point u, std::vector<Point> &path,
             visited.erase(e);
         }
     }
+}
+
+std::size_t BoundaryGraph::DeadStateHash::operator()(const DeadState &s) const {
+    std::uint64_t h = (std::uint64_t)s.u * 131 + (std::uint64_t)(s.prev + 1);
+    for (int i = 0; i < 4; i++) {
+        h ^= s.used.w[i] + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return (std::size_t)h;
+}
+
+// adj を密な表に変換する
+// 格子の外の頂点や重複した辺があるときは false を返す
+bool BoundaryGraph::buildDense() {
+    std::fill(dense_degree, dense_degree + NUM_VERTICES, 0);
+
+    EdgeMask seen;
+    int num_edges = 0;
+    for (const auto &kv : adj) {
+        const Point &a = kv.first;
+        if (a.x < 0 || a.x >= GRID || a.y < 0 || a.y >= GRID)
+            return false;
+        if (kv.second.size() > 4)
+            return false;
+
+        int id = a.x * GRID + a.y;
+        for (const auto &b : kv.second) {
+            int e;
+            if (b.y == a.y && std::abs(b.x - a.x) == 1)
+                e = a.y * 8 + std::min(a.x, b.x);
+            else if (b.x == a.x && std::abs(b.y - a.y) == 1)
+                e = 72 + a.x * 8 + std::min(a.y, b.y);
+            else
+                return false;
+            if (b.x < 0 || b.x >= GRID || b.y < 0 || b.y >= GRID)
+                return false;
+
+            // 各辺は両端から1回ずつ数える
+            if (!seen.test(e)) {
+                seen.flip(e);
+                num_edges++;
+            }
+            int k = dense_degree[id]++;
+            dense_next[id][k] = b.x * GRID + b.y;
+            dense_edge[id][k] = e;
+        }
+    }
+    return num_edges == total_edges;
+}
+
+// 始点から密な表現でサイクルを探索する
+// first が -1 でなければ、始点から最初に first へ進むサイクルだけを探す
+//
+// 探索木を parallel_depth 歩まで幅優先に展開し、途中までの経路ごとに
+// 並列に探索する。展開は隣接頂点の順を保つので、タスクの順に結果を
+// つなげると逐次に探索したときと同じ順になる
+// sink があれば、サイクルは見つけた時点で sink に渡す（順番は保たない）
+void BoundaryGraph::findDenseCycles(int first,
+                                    std::vector<DenseCycle> &results,
+                                    const DenseSink *sink) {
+    Point start = adj.begin()->first;
+    int s = start.x * GRID + start.y;
+
+    DensePrefix root{{s}, EdgeMask(), 0, ALL_SLIDES};
+    std::vector<DensePrefix> frontier;
+    if (first == -1) {
+        frontier.push_back(root);
+    } else {
+        for (int k = 0; k < dense_degree[s]; k++) {
+            DensePrefix next;
+            if (dense_next[s][k] == first && stepDense(root, k, next)) {
+                frontier.push_back(next);
+                break;
+            }
+        }
+    }
+
+    for (int d = 0; d < parallel_depth; d++) {
+        std::vector<DensePrefix> expanded;
+        bool grown = false;
+        for (const auto &p : frontier) {
+            // すべての辺を使った経路はそのまま残す
+            if ((int)p.path.size() - 1 == total_edges) {
+                expanded.push_back(p);
+                continue;
+            }
+            int u = p.path.back();
+            for (int k = 0; k < dense_degree[u]; k++) {
+                DensePrefix next;
+                if (stepDense(p, k, next)) {
+                    expanded.push_back(next);
+                    grown = true;
+                }
+            }
+        }
+        frontier.swap(expanded);
+        if (!grown)
+            break;
+    }
+
+    int num_tasks = frontier.size();
+    std::vector<std::vector<DenseCycle>> task_results(num_tasks);
+    std::atomic<bool> stop(false);
+
+#pragma omp parallel
+    {
+        DenseSearch ds;
+        ds.max_dead_states = MAX_DEAD_STATES / omp_get_num_threads();
+        ds.sink = sink;
+        ds.stop = &stop;
+
+#pragma omp for schedule(dynamic, 1)
+        for (int i = 0; i < num_tasks; i++) {
+            if (stop.load(std::memory_order_relaxed))
+                continue;
+            DensePrefix &p = frontier[i];
+            int n = p.path.size();
+            for (int pos = 0; pos < n && pos < 32; pos++) {
+                ds.path_x[pos] = p.path[pos] / GRID;
+                ds.path_y[pos] = p.path[pos] % GRID;
+            }
+            int u = p.path[n - 1];
+            int prev = (n >= 2) ? p.path[n - 2] : -1;
+            backtrackDense(ds, u, prev, p.used, n - 1, p.turn, p.slides,
+                           p.path, task_results[i]);
+        }
+    }
+
+    for (auto &r : task_results)
+        results.insert(results.end(), r.begin(), r.end());
+}
+
+// 隣接頂点 k へ進めるか（辺が未使用で、十字路で直進しない）
+bool BoundaryGraph::canMove(int u, int prev, int k,
+                            const EdgeMask &used) const {
+    int v = dense_next[u][k];
+    if (used.test(dense_edge[u][k]))
+        return false;
+    if (prev != -1 && dense_degree[u] == 4) {
+        if (prev / GRID == v / GRID || prev % GRID == v % GRID)
+            return false;
+    }
+    return true;
+}
+
+// 途中までの経路 p から隣接頂点 k へ1歩進めた経路を next に入れる
+// 進めないときは false を返す
+bool BoundaryGraph::stepDense(const DensePrefix &p, int k,
+                              DensePrefix &next) const {
+    int n = p.path.size();
+    int u = p.path[n - 1];
+    int prev = (n >= 2) ? p.path[n - 2] : -1;
+    if (!canMove(u, prev, k, p.used))
+        return false;
+
+    int v = dense_next[u][k];
+    next.slides = p.slides;
+    if (prune_distance && n < 32) {
+        int xs[32], ys[32];
+        for (int pos = 0; pos < n; pos++) {
+            xs[pos] = p.path[pos] / GRID;
+            ys[pos] = p.path[pos] % GRID;
+        }
+        xs[n] = v / GRID;
+        ys[n] = v % GRID;
+        next.slides = update_slides(p.slides, n, xs, ys);
+        if (next.slides == 0)
+            return false;
+    }
+
+    next.path = p.path;
+    next.path.push_back(v);
+    next.used = p.used;
+    next.used.flip(dense_edge[u][k]);
+    next.turn = p.turn + ((prev == -1) ? 0 : getTurn(prev, u, v));
+    return true;
+}
+
+// prev -> u -> v と進むときの曲がり方（右折 1、左折 -1、直進 0）
+// getPathDirections と同じ判定
+int BoundaryGraph::getTurn(int prev, int u, int v) const {
+    int dx_in = u / GRID - prev / GRID;
+    int dy_in = u % GRID - prev % GRID;
+    int dx_out = v / GRID - u / GRID;
+    int dy_out = v % GRID - u % GRID;
+    int cp = dx_in * dy_out - dy_in * dx_out;
+    return (cp > 0) - (cp < 0);
+}
+
+// サイクルの各頂点で、次の頂点が隣接頂点の何番目か
+std::vector<int> BoundaryGraph::getChoices(const std::vector<int> &path) const {
+    std::vector<int> choices;
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        int u = path[i];
+        for (int k = 0; k < dense_degree[u]; k++) {
+            if (dense_next[u][k] == path[i + 1]) {
+                choices.push_back(k);
+                break;
+            }
+        }
+    }
+    return choices;
+}
+
+std::vector<Point>
+BoundaryGraph::toPoints(const std::vector<int> &path) const {
+    std::vector<Point> points;
+    for (int v : path)
+        points.push_back(Point{v / GRID, v % GRID});
+    return points;
+}
+
+void BoundaryGraph::backtrackDense(DenseSearch &ds, int u, int prev,
+                                   EdgeMask &used, int num_used, int turn,
+                                   unsigned int slides, std::vector<int> &path,
+                                   std::vector<DenseCycle> &results) const {
+    if (ds.stop->load(std::memory_order_relaxed))
+        return;
+
+    if (num_used == total_edges) {
+        if (u == path[0]) {
+            // 始点での曲がり方を加えて閉じる
+            int closing = getTurn(prev, u, path[1]);
+            ds.found++;
+            if (ds.sink == nullptr) {
+                results.push_back({path, turn + closing});
+            } else {
+                bool go;
+#pragma omp critical(boundary_graph_sink)
+                go = (*ds.sink)(path, turn + closing);
+                if (!go)
+                    ds.stop->store(true, std::memory_order_relaxed);
+            }
+        }
+        return;
+    }
+
+    DeadState state{used, u, prev};
+    if (ds.dead_states.count(state))
+        return;
+
+    unsigned long long found = ds.found;
+    unsigned long long pruned = ds.distance_pruned;
+    for (int k = 0; k < dense_degree[u]; k++) {
+        if (!canMove(u, prev, k, used))
+            continue;
+        int v = dense_next[u][k];
+        int e = dense_edge[u][k];
+
+        // 次の頂点をループの位置 num_used + 1 に置いても
+        // 距離条件を満たすズラシが残るか
+        unsigned int next_slides = slides;
+        int pos = num_used + 1;
+        if (prune_distance && pos < 32) {
+            ds.path_x[pos] = v / GRID;
+            ds.path_y[pos] = v % GRID;
+            next_slides = update_slides(slides, pos, ds.path_x, ds.path_y);
+            if (next_slides == 0) {
+                ds.distance_pruned++;
+                continue;
+            }
+        }
+
+        int t = (prev == -1) ? 0 : getTurn(prev, u, v);
+        used.flip(e);
+        path.push_back(v);
+        backtrackDense(ds, v, u, used, num_used + 1, turn + t, next_slides,
+                       path, results);
+        path.pop_back();
+        used.flip(e);
+    }
+
+    // 距離条件で枝刈りした部分木があれば、それまでの経路によらず
+    // サイクルが無いとは言えないので記録しない
+    // 途中でやめた部分木も記録しない
+    if (ds.found == found && ds.distance_pruned == pruned &&
+        !ds.stop->load(std::memory_order_relaxed) &&
+        ds.dead_states.size() < ds.max_dead_states)
+        ds.dead_states.insert(state);
 }
\ No newline at end of file
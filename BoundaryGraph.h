@@ -1,11 +1,18 @@
 #pragma once
 
+#include "distanceConstraint.h"
+#include "packedLoop.h"
+
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <set>
 #include <string>
 #include <tuple>
+#include <unordered_set>
 #include <vector>
 
 struct Point {
@@ -19,6 +26,18 @@ struct Edge {
     bool operator<(const Edge &o) const;
 };
 
+// 格子点 (x, y) (0 <= x, y <= 8) の間の144本の辺の集合
+// 横の辺 (x, y)-(x+1, y) は y * 8 + x、縦の辺 (x, y)-(x, y+1) は 72 + x * 8 + y
+struct EdgeMask {
+    std::uint64_t w[4] = {0, 0, 0, 0};
+    bool test(int e) const { return (w[e >> 6] >> (e & 63)) & 1; }
+    void flip(int e) { w[e >> 6] ^= 1ULL << (e & 63); }
+    bool operator==(const EdgeMask &o) const {
+        return w[0] == o.w[0] && w[1] == o.w[1] && w[2] == o.w[2] &&
+               w[3] == o.w[3];
+    }
+};
+
 class BoundaryGraph {
   public:
     std::map<Point, std::vector<Point>> adj; // 隣接リスト
@@ -49,9 +68,97 @@ class BoundaryGraph {
 
     std::vector<std::vector<Point>> findClockwiseCycles();
 
+    // findClockwiseCycles のうち、距離条件を満たすズラシがあるものだけを返す
+    // 条件は探索しながら判定し、満たすズラシが無くなった時点で枝刈りする
+    std::vector<std::vector<Point>> findFeasibleClockwiseCycles();
+
+    // findFeasibleClockwiseCycles のうち32辺のものを PackedLoop にして返す
+    std::vector<PackedLoop> findFeasibleClockwiseLoops();
+
+    // findFeasibleClockwiseLoops と同じループを、見つかった順に visit に渡す
+    // visit が false を返すと探索をやめる
+    // 並べ替えないので、順番は findFeasibleClockwiseLoops と同じとは限らない
+    void streamFeasibleClockwiseLoops(
+        const std::function<bool(const PackedLoop &)> &visit);
+
+    // 密な表現での探索を並列化するとき、幅優先に展開する深さ
+    // 展開した途中までの経路をそれぞれ1つのタスクとしてスレッドに割り振る
+    int parallel_depth = 8;
+
     void removeEdge(Edge e);
 
   private:
     void backtrack(Point u, std::vector<Point> &path, std::set<Edge> &visited,
                    std::vector<std::vector<Point>> &results);
+
+    // 頂点を x * 9 + y の番号で表した密な表現での探索
+    // 隣接頂点の順番は adj と同じなので、backtrack と同じ順にサイクルが見つかる
+    static const int GRID = 9;
+    static const int NUM_VERTICES = GRID * GRID;
+    static const int MAX_DEAD_STATES = 1 << 19;
+
+    // (現在の頂点, 直前の頂点, 使用済みの辺) : ここから1つもサイクルが
+    // 得られないと分かった状態
+    struct DeadState {
+        EdgeMask used;
+        int u, prev;
+        bool operator==(const DeadState &o) const {
+            return u == o.u && prev == o.prev && used == o.used;
+        }
+    };
+    struct DeadStateHash {
+        std::size_t operator()(const DeadState &s) const;
+    };
+
+    // 見つかったサイクルと、その右折の数から左折の数を引いた値
+    struct DenseCycle {
+        std::vector<int> path;
+        int turn;
+    };
+
+    // 途中までの経路
+    struct DensePrefix {
+        std::vector<int> path;
+        EdgeMask used;
+        int turn;
+        unsigned int slides;
+    };
+
+    // 見つけたサイクル（経路と曲がり方の合計）をすぐに受け取る関数
+    // false を返すと探索をやめる
+    using DenseSink = std::function<bool(const std::vector<int> &, int)>;
+
+    // スレッドごとの探索の作業領域
+    // 無駄な状態は始点と使用済みの辺だけで決まるので、タスクをまたいで使える
+    struct DenseSearch {
+        std::unordered_set<DeadState, DeadStateHash> dead_states;
+        std::size_t max_dead_states = MAX_DEAD_STATES;
+        unsigned long long distance_pruned = 0;
+        unsigned long long found = 0;
+        int path_x[32], path_y[32];
+        const DenseSink *sink = nullptr; // nullptr なら results にためる
+        std::atomic<bool> *stop = nullptr;
+    };
+
+    int dense_degree[NUM_VERTICES];
+    int dense_next[NUM_VERTICES][4];
+    int dense_edge[NUM_VERTICES][4];
+
+    // 距離条件での枝刈り
+    bool prune_distance = false;
+
+    bool buildDense();
+    void findDenseCycles(int first, std::vector<DenseCycle> &results,
+                         const DenseSink *sink = nullptr);
+    bool stepDense(const DensePrefix &p, int k, DensePrefix &next) const;
+    bool canMove(int u, int prev, int k, const EdgeMask &used) const;
+    void backtrackDense(DenseSearch &ds, int u, int prev, EdgeMask &used,
+                        int num_used, int turn, unsigned int slides,
+                        std::vector<int> &path,
+                        std::vector<DenseCycle> &results) const;
+    std::vector<std::vector<Point>> enumerateClockwiseCycles(bool distance);
+    bool hasFeasibleSlide(const std::vector<Point> &cycle) const;
+    int getTurn(int prev, int u, int v) const;
+    std::vector<int> getChoices(const std::vector<int> &path) const;
+    std::vector<Point> toPoints(const std::vector<int> &path) const;
 };
\ No newline at end of file
@@ -0,0 +1,277 @@
+#ifndef CIRCUIT_COUNTER_HPP
+#define CIRCUIT_COUNTER_HPP
+
+// 一筆書きを列挙する前に、その数を BEST 定理で数える
+// 列挙をすべて行うか、サンプリングにするか、どう分割するかを決めるのに使う
+//
+// 向きのついたオイラーグラフのオイラー回路の数は
+//   ec(G) = t_w(G) * Π_v (出次数(v) - 1)!
+// （t_w は頂点 w に向かう全域有向木の数で、行列木定理により
+//   ラプラシアンから w の行と列を除いた行列式）
+// 行列式は素数 2^61 - 1 を法とするガウスの消去法で求める
+// 数がそれより小さければ正確な値になる
+//
+// 境界の辺 F は、十字路で曲がる限り黒いマスを右に見る向きにそろって通る
+// 十字路では入る辺と出る辺が2本ずつで、どちらにつないでも曲がるので、
+// F が連結なら十字路で曲がるループの数は F に向きをつけたグラフの ec そのもの
+// 島を往復する辺でつないだ歩き方では、島ごとに回る向きが2通りあり、
+// 往復する辺は行きと帰りで1回ずつ通るとして、島の向きの組ごとに足し合わせる
+// （回転と反転を同じ歩き方とみなす。往復する辺の端でのUターンなど
+//   十字路以外での曲がり方は制限しないので、条件で絞る前の見積もり）
+
+#include "EulerSolver.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class CircuitCounter
+{
+public:
+    static constexpr std::uint64_t MOD = (1ULL << 61) - 1;
+
+    // 歩き方の数と、数えるのにかかった時間
+    struct Estimate
+    {
+        std::uint64_t circuits = 0;
+        long long micros = 0;
+    };
+
+    /**
+     * @brief 向きのついた多重グラフのオイラー回路の数（頂点の列として。回転は同じとみなす）
+     * @param arcs 弧 (from, to) の列。同じ弧を k 回入れれば多重度 k
+     */
+    static std::uint64_t count_directed(const std::vector<Edge> &arcs)
+    {
+        if (arcs.empty())
+            return 0;
+
+        // 弧を持つ頂点に番号をつけ直す
+        std::array<int, 81> index;
+        index.fill(-1);
+        std::array<int, 81> out_deg{}, in_deg{};
+        int n = 0;
+        for (const auto &a : arcs)
+        {
+            for (Node v : {a.first, a.second})
+            {
+                if (index[v] < 0)
+                    index[v] = n++;
+            }
+            out_deg[a.first]++;
+            in_deg[a.second]++;
+        }
+        for (Node v = 0; v < 81; ++v)
+        {
+            if (out_deg[v] != in_deg[v])
+                return 0;
+        }
+
+        // ラプラシアン（出次数 - 隣接）から最初の頂点の行と列を除く
+        int m = n - 1;
+        std::vector<std::uint64_t> lap(m * m, 0);
+        std::array<std::uint8_t, 81 * 81> multiplicity{};
+        for (const auto &a : arcs)
+        {
+            multiplicity[a.first * 81 + a.second]++;
+            int i = index[a.first] - 1, j = index[a.second] - 1;
+            if (i < 0)
+                continue;
+            lap[i * m + i] = add(lap[i * m + i], 1);
+            if (j >= 0)
+                lap[i * m + j] = sub(lap[i * m + j], 1);
+        }
+
+        std::uint64_t count = determinant(lap, m);
+        for (Node v = 0; v < 81; ++v)
+        {
+            if (out_deg[v] > 0)
+                count = mul(count, factorial(out_deg[v] - 1));
+        }
+        // 同じ弧どうしを入れ替えても頂点の列は変わらない
+        for (int k : multiplicity)
+        {
+            if (k > 1)
+                count = mul(count, inverse(factorial(k)));
+        }
+        return count;
+    }
+
+    /**
+     * @brief 辺の使い方 counts の歩き方のうち、島ごとに一方向に回るものの数
+     * @param F 境界の辺
+     * @param counts 各辺を通る回数（F の辺は奇数回、それ以外は偶数回）
+     */
+    static std::uint64_t count_walks(const EdgeList &F, const EdgeCounts &counts)
+    {
+        // F の縦の辺の偶奇からドット絵を復元し、黒を右に見る向きを決める
+        std::array<bool, NUM_GRID_EDGES> is_f{};
+        for (const auto &e : F)
+        {
+            int id = grid_edge_id(e.first, e.second);
+            if (id >= 0)
+                is_f[id] = true;
+        }
+        auto black = [&](int x, int y)
+        {
+            if (x < 0 || x >= 8 || y < 0 || y >= 8)
+                return false;
+            bool inside = false;
+            for (int i = 0; i <= x; ++i)
+                inside ^= is_f[grid_edge_id(y * 9 + i, (y + 1) * 9 + i)];
+            return inside;
+        };
+
+        // F の辺の向きと、往復する辺の弧
+        UnionFind uf(81);
+        std::vector<Edge> f_arcs, pair_arcs;
+        for (int y = 0; y < 9; ++y)
+        {
+            for (int x = 0; x < 9; ++x)
+            {
+                Node u = y * 9 + x;
+                for (int dir = 0; dir < 2; ++dir)
+                {
+                    Node v = dir == 0 ? u + 1 : u + 9;
+                    if ((dir == 0 && x == 8) || (dir == 1 && y == 8))
+                        continue;
+                    int id = grid_edge_id(u, v);
+                    int c = counts[id];
+                    if (is_f[id])
+                    {
+                        // 横の辺は下、縦の辺は左が黒なら u -> v
+                        bool forward = dir == 0 ? black(x, y) : black(x - 1, y);
+                        f_arcs.push_back(forward ? Edge(u, v) : Edge(v, u));
+                        uf.unite(u, v);
+                        c--;
+                    }
+                    for (int k = 0; k + 1 < c; k += 2)
+                    {
+                        pair_arcs.push_back({u, v});
+                        pair_arcs.push_back({v, u});
+                    }
+                }
+            }
+        }
+        if (f_arcs.empty())
+            return 0;
+
+        // 島ごとの向きの組（最初の島の向きは固定して、反転を同じとみなす）
+        std::array<int, 81> island;
+        island.fill(-1);
+        int num_islands = 0;
+        for (const auto &a : f_arcs)
+        {
+            int r = uf.find(a.first);
+            if (island[r] < 0)
+                island[r] = num_islands++;
+        }
+
+        std::uint64_t total = 0;
+        for (int mask = 0; mask < (1 << (num_islands - 1)); ++mask)
+        {
+            std::vector<Edge> arcs = pair_arcs;
+            for (const auto &a : f_arcs)
+            {
+                int i = island[uf.find(a.first)];
+                bool flip = i > 0 && ((mask >> (i - 1)) & 1);
+                arcs.push_back(flip ? Edge(a.second, a.first) : a);
+            }
+            total = add(total, count_directed(arcs));
+        }
+        return total;
+    }
+
+    /**
+     * @brief 辺の使い方の列 covers 全体での歩き方の数と、数えるのにかかった時間
+     */
+    static Estimate estimate(const EdgeList &F, const std::vector<EdgeCounts> &covers)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Estimate e;
+        for (const auto &c : covers)
+            e.circuits = add(e.circuits, count_walks(F, c));
+        e.micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+        return e;
+    }
+
+private:
+    static std::uint64_t add(std::uint64_t a, std::uint64_t b)
+    {
+        std::uint64_t s = a + b;
+        return s >= MOD ? s - MOD : s;
+    }
+
+    static std::uint64_t sub(std::uint64_t a, std::uint64_t b)
+    {
+        return a >= b ? a - b : a + MOD - b;
+    }
+
+    static std::uint64_t mul(std::uint64_t a, std::uint64_t b)
+    {
+        unsigned __int128 p = (unsigned __int128)a * b;
+        std::uint64_t lo = (std::uint64_t)(p & MOD), hi = (std::uint64_t)(p >> 61);
+        return add(lo, hi);
+    }
+
+    static std::uint64_t inverse(std::uint64_t a)
+    {
+        // フェルマーの小定理 a^(p-2)
+        std::uint64_t r = 1, e = MOD - 2;
+        while (e > 0)
+        {
+            if (e & 1)
+                r = mul(r, a);
+            a = mul(a, a);
+            e >>= 1;
+        }
+        return r;
+    }
+
+    static std::uint64_t factorial(int k)
+    {
+        std::uint64_t r = 1;
+        for (int i = 2; i <= k; ++i)
+            r = mul(r, i);
+        return r;
+    }
+
+    // m x m 行列 a の行列式（a は壊す）
+    static std::uint64_t determinant(std::vector<std::uint64_t> &a, int m)
+    {
+        std::uint64_t det = 1;
+        for (int col = 0; col < m; ++col)
+        {
+            int pivot = -1;
+            for (int r = col; r < m && pivot < 0; ++r)
+            {
+                if (a[r * m + col] != 0)
+                    pivot = r;
+            }
+            if (pivot < 0)
+                return 0;
+            if (pivot != col)
+            {
+                for (int k = 0; k < m; ++k)
+                    std::swap(a[pivot * m + k], a[col * m + k]);
+                det = sub(0, det);
+            }
+            det = mul(det, a[col * m + col]);
+            std::uint64_t inv = inverse(a[col * m + col]);
+            for (int r = col + 1; r < m; ++r)
+            {
+                std::uint64_t f = mul(a[r * m + col], inv);
+                if (f == 0)
+                    continue;
+                for (int k = col; k < m; ++k)
+                    a[r * m + k] = sub(a[r * m + k], mul(f, a[col * m + k]));
+            }
+        }
+        return det;
+    }
+};
+
+#endif
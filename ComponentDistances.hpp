@@ -0,0 +1,135 @@
+#ifndef COMPONENT_DISTANCES_HPP
+#define COMPONENT_DISTANCES_HPP
+
+// 格子上の連結成分どうしの最短マンハッタン距離と、その距離を実現する頂点ペア
+// 頂点番号は y * width + x
+//
+// 全成分を始点にした幅優先探索を1回だけ行い、各頂点について
+// 「成分 c の頂点までの距離」の場（成分ごとの距離場）を作る
+// 障害物のない格子なので、この距離はマンハッタン距離と一致する
+// 成分 i と j の距離は j の頂点における i の距離場の最小値で、
+// 最短の頂点ペアは両側の距離場がその値になる頂点の中だけから探せばよい
+// 結果は成分ペア (i, j) ごとに i * count + j の位置に並べた平坦な配列で持つ
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+class ComponentDistances
+{
+private:
+    int width, height;
+    int k;                                                // 成分の数
+    std::vector<int> fields;                              // [c * V + v] : 頂点 v から成分 c までの距離
+    std::vector<int> dists;                               // [i * k + j] : 成分 i, j の距離
+    std::vector<std::vector<std::pair<int, int>>> pairs; // [i * k + j] : 最短の頂点ペア (i 側, j 側)
+
+public:
+    static constexpr int INF = 1000000000;
+
+    // components[c] は成分 c の頂点のリスト
+    ComponentDistances(int w, int h, const std::vector<std::vector<int>> &components)
+        : width(w), height(h), k(components.size())
+    {
+        int V = width * height;
+        fields.assign(k * V, INF);
+        dists.assign(k * k, INF);
+        pairs.assign(k * k, {});
+
+        // 1. 全成分の頂点を始点にした幅優先探索
+        //    キューには (成分, 頂点) を入れ、成分ごとに各頂点を一度だけ訪れる
+        std::vector<std::pair<int, int>> queue;
+        queue.reserve(k * V);
+        for (int c = 0; c < k; ++c)
+        {
+            for (int v : components[c])
+            {
+                if (fields[c * V + v] != 0)
+                {
+                    fields[c * V + v] = 0;
+                    queue.push_back({c, v});
+                }
+            }
+        }
+
+        static const int dx[4] = {1, -1, 0, 0};
+        static const int dy[4] = {0, 0, 1, -1};
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            auto [c, u] = queue[head];
+            int d = fields[c * V + u];
+            int x = u % width;
+            int y = u / width;
+            for (int i = 0; i < 4; ++i)
+            {
+                int nx = x + dx[i];
+                int ny = y + dy[i];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                    continue;
+                int v = ny * width + nx;
+                if (fields[c * V + v] != INF)
+                    continue;
+                fields[c * V + v] = d + 1;
+                queue.push_back({c, v});
+            }
+        }
+
+        // 2. 成分ペアごとの距離と、最短の頂点ペア
+        for (int i = 0; i < k; ++i)
+        {
+            for (int j = i + 1; j < k; ++j)
+            {
+                int d = INF;
+                for (int v : components[j])
+                    d = std::min(d, fields[i * V + v]);
+                if (d == INF)
+                    continue;
+
+                // 相手の成分までの距離が d の頂点だけが候補になる
+                std::vector<int> near_j;
+                for (int v : components[j])
+                {
+                    if (fields[i * V + v] == d)
+                        near_j.push_back(v);
+                }
+
+                // 並びは components[i] の順、その中で components[j] の順
+                std::vector<std::pair<int, int>> &best = pairs[i * k + j];
+                for (int u : components[i])
+                {
+                    if (fields[j * V + u] != d)
+                        continue;
+                    for (int v : near_j)
+                    {
+                        if (manhattan(u, v) == d)
+                            best.push_back({u, v});
+                    }
+                }
+
+                dists[i * k + j] = dists[j * k + i] = d;
+                auto &rev = pairs[j * k + i];
+                for (const auto &[u, v] : best)
+                    rev.push_back({v, u});
+            }
+        }
+    }
+
+    int count() const { return k; }
+
+    int manhattan(int u, int v) const
+    {
+        return std::abs(u % width - v % width) + std::abs(u / width - v / width);
+    }
+
+    // 頂点 v から成分 c までの距離
+    int field(int c, int v) const { return fields[c * width * height + v]; }
+
+    // 成分 i, j の距離（つながらなければ INF）
+    int dist(int i, int j) const { return dists[i * k + j]; }
+
+    // 成分 i, j の間で距離 dist(i, j) を実現する頂点ペア (i 側, j 側)
+    const std::vector<std::pair<int, int>> &best_pairs(int i, int j) const { return pairs[i * k + j]; }
+};
+
+#endif
@@ -0,0 +1,479 @@
+#ifndef COVER_DIAGRAM_HPP
+#define COVER_DIAGRAM_HPP
+
+// 境界の辺集合 F をすべて通る閉じた歩き方のうち、余分な長さが最小のものの
+// 辺の使い方（各辺を何回通るか）を表す決定図（ZDD）
+//
+// F の頂点の次数はすべて偶数なので、閉じた歩き方は
+//   F の辺を1回、それ以外に「往復する辺」の集合 D を2回ずつ通る
+// 多重グラフが連結であれば作れる
+// 余分な長さは 2|D| なので、決定図は F ∪ D が連結になる D の集合を表し、
+// そのうち |D| が最小のものだけを数え上げ・サンプリング・列挙に使う
+// 橋の選び方（MST）に限らないので、3つ以上の島を1点でつなぐ形も含む
+//
+// 9x9 グリッドの144本の辺を頂点番号の順に並べ、各辺を D に入れるかを
+// 変数として上から決める（simpath と同じフロンティア法）
+// フロンティア（処理中の辺に触れる頂点）の連結成分の番号づけを状態とし、
+// 等しい状態の節点は共有する
+// フロンティアから出ていった成分は二度とつながらないので、それが最後の成分で
+// なければ捨てる
+//
+// 最小にならない D は作らない
+//   - F の辺を D に入れる（すでにつながっている）
+//   - すでに同じ成分にある2頂点の間の辺を D に入れる（閉路ができる）
+//   - F の頂点でないのに D の辺が1本しかない頂点（行き止まり）
+//   - F の頂点を囲む長方形の外の辺を D に入れる（長方形に押し込むと短くなる）
+//   - 島を最小全域木でつないだときの往復の本数より多く D に入れる
+// 状態には、フロンティアの各頂点が行き止まりかどうかと、D に入れた本数も持つ
+//
+// 決定図が表すのは辺の使用回数までで、歩く順序は EulerSolver が決める
+
+#include "EulerSolver.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+class CoverDiagram
+{
+private:
+    static constexpr int LEVELS = NUM_GRID_EDGES;
+    static constexpr int ZERO = 0; // 0 終端
+    static constexpr int ONE = 1;  // 1 終端
+    static constexpr int INF = std::numeric_limits<int>::max() / 2;
+    // 状態の値の中の位置（フロンティアは11頂点以下）
+    //   0..43 bit : 成分番号を4bitずつ、44..54 bit : 行き止まりか、56.. bit : D に入れた本数
+    static constexpr int DANGLING_SHIFT = 44;
+    static constexpr int WEIGHT_SHIFT = 56;
+
+    // 辺を処理する順（頂点 u = y * 9 + x の順に、右の辺・下の辺）
+    struct LevelEdge
+    {
+        Node u, v;
+        int id; // grid_edge_id
+    };
+    std::vector<LevelEdge> order;
+
+    struct DDNode
+    {
+        int level;
+        int lo, hi; // lo : D に入れない、hi : D に入れる
+    };
+    std::vector<DDNode> nodes; // 0, 1 は終端
+    int root = ZERO;
+
+    EdgeCounts base{};             // F の辺を1回ずつ
+    std::array<bool, 81> is_f_vertex{};
+    int extra_limit = 0;           // D に入れる本数の上限
+    std::vector<int> min_weight;   // 節点から 1 終端までに D に入れる辺の最小本数
+    std::vector<std::uint64_t> num; // その最小本数で 1 終端に届く道の数
+
+public:
+    explicit CoverDiagram(const EdgeList &F)
+    {
+        for (Node u = 0; u < 81; ++u)
+        {
+            if (u % 9 != 8)
+                order.push_back({u, u + 1, grid_edge_id(u, u + 1)});
+            if (u + 9 < 81)
+                order.push_back({u, u + 9, grid_edge_id(u, u + 9)});
+        }
+
+        nodes.push_back({LEVELS, ZERO, ZERO});
+        nodes.push_back({LEVELS, ONE, ONE});
+
+        for (const auto &e : F)
+        {
+            int id = grid_edge_id(e.first, e.second);
+            if (id < 0)
+                return;
+            base[id] = 1;
+            is_f_vertex[e.first] = is_f_vertex[e.second] = true;
+        }
+        if (F.empty())
+            return;
+
+        extra_limit = spanning_tree_extra(F);
+        build();
+        count_minimum();
+    }
+
+    bool empty() const { return root == ZERO; }
+
+    // 決定図の節点数（終端を除く）
+    std::size_t size() const { return nodes.size() - 2; }
+
+    // 往復する辺の最小本数（余分な長さはこの2倍）
+    int min_extra_edges() const { return empty() ? -1 : min_weight[root]; }
+
+    // 余分な長さが最小になる辺の使い方の数（64bit で飽和する）
+    std::uint64_t count() const { return empty() ? 0 : num[root]; }
+
+    // 余分な長さが最小になる辺の使い方を一様に1つ選ぶ
+    EdgeCounts sample(std::mt19937_64 &rng) const
+    {
+        EdgeCounts counts = base;
+        int n = root;
+        while (n > ONE)
+        {
+            const DDNode &d = nodes[n];
+            std::uint64_t lo = on_minimum(n, false) ? num[d.lo] : 0;
+            std::uint64_t hi = on_minimum(n, true) ? num[d.hi] : 0;
+            std::uniform_int_distribution<std::uint64_t> dist(0, lo + hi - 1);
+            if (dist(rng) < lo)
+            {
+                n = d.lo;
+            }
+            else
+            {
+                counts[order[d.level].id] += 2;
+                n = d.hi;
+            }
+        }
+        return counts;
+    }
+
+    // 余分な長さが最小になる辺の使い方をすべて f(const EdgeCounts &) に渡す
+    // f が false を返したらそこで止める
+    template <typename Func>
+    void for_each(Func &&f) const
+    {
+        if (empty())
+            return;
+        EdgeCounts counts = base;
+        enumerate(root, counts, f);
+    }
+
+    // 同上。結果を配列で返す
+    std::vector<EdgeCounts> all() const
+    {
+        std::vector<EdgeCounts> covers;
+        for_each([&](const EdgeCounts &c)
+                 { covers.push_back(c); return true; });
+        return covers;
+    }
+
+private:
+    // 島どうしを最短の橋の最小全域木でつないだときの橋の長さの合計
+    static int spanning_tree_extra(const EdgeList &F)
+    {
+        ComponentManager cm;
+        auto comps = cm.extract_components(F);
+        auto bridges = cm.compute_all_bridges(comps);
+        std::stable_sort(bridges.begin(), bridges.end(), [](const Bridge &a, const Bridge &b)
+                         { return a.dist < b.dist; });
+        UnionFind uf(comps.size());
+        int total = 0;
+        for (const auto &b : bridges)
+        {
+            if (uf.unite(b.comp1_id, b.comp2_id))
+                total += b.dist;
+        }
+        return total;
+    }
+
+    // 節点 n から lo / hi に進む枝が最小の道に乗っているか
+    bool on_minimum(int n, bool take) const
+    {
+        const DDNode &d = nodes[n];
+        int child = take ? d.hi : d.lo;
+        return min_weight[child] != INF && min_weight[child] + (take ? 1 : 0) == min_weight[n];
+    }
+
+    template <typename Func>
+    bool enumerate(int n, EdgeCounts &counts, Func &f) const
+    {
+        if (n == ONE)
+            return f(static_cast<const EdgeCounts &>(counts));
+        const DDNode &d = nodes[n];
+        if (on_minimum(n, false) && !enumerate(d.lo, counts, f))
+            return false;
+        if (on_minimum(n, true))
+        {
+            int id = order[d.level].id;
+            counts[id] += 2;
+            bool go_on = enumerate(d.hi, counts, f);
+            counts[id] -= 2;
+            if (!go_on)
+                return false;
+        }
+        return true;
+    }
+
+    void build()
+    {
+        // 各頂点が最初・最後に現れる辺の番号
+        std::vector<int> first(81, LEVELS), last(81, -1);
+        for (int i = 0; i < LEVELS; ++i)
+        {
+            for (Node w : {order[i].u, order[i].v})
+            {
+                first[w] = std::min(first[w], i);
+                last[w] = std::max(last[w], i);
+            }
+        }
+
+        // frontier[i] : 辺 i を処理するときに状態として持つ頂点（番号順）
+        std::vector<std::vector<Node>> frontier(LEVELS + 1);
+        for (int i = 0; i <= LEVELS; ++i)
+        {
+            for (Node w = 0; w < 81; ++w)
+            {
+                if (first[w] <= i && i <= last[w])
+                    frontier[i].push_back(w);
+            }
+        }
+
+        // F の頂点を囲む長方形の中の辺か
+        int min_x = 8, max_x = 0, min_y = 8, max_y = 0;
+        for (Node w = 0; w < 81; ++w)
+        {
+            if (!is_f_vertex[w])
+                continue;
+            min_x = std::min(min_x, w % 9);
+            max_x = std::max(max_x, w % 9);
+            min_y = std::min(min_y, w / 9);
+            max_y = std::max(max_y, w / 9);
+        }
+        std::vector<bool> in_box(LEVELS);
+        for (int i = 0; i < LEVELS; ++i)
+        {
+            Node v = order[i].v;
+            in_box[i] = order[i].u % 9 >= min_x && v % 9 <= max_x && order[i].u / 9 >= min_y && v / 9 <= max_y;
+        }
+
+        // 辺 i 以降に残っている F の辺の数
+        std::vector<int> f_after(LEVELS + 1, 0);
+        for (int i = LEVELS - 1; i >= 0; --i)
+            f_after[i] = f_after[i + 1] + base[order[i].id];
+
+        // 状態は frontier[i] の各頂点の成分番号（0 は辺がまだない）と行き止まりか、
+        // D に入れた本数を詰めた値
+        // 上の段から順に、各段の状態ごとに1つの節点を作る
+        std::vector<std::unordered_map<std::uint64_t, int>> level_states(LEVELS + 1);
+        std::vector<std::vector<std::uint64_t>> level_keys(LEVELS + 1);
+        std::vector<DDNode> raw{{LEVELS, ZERO, ZERO}, {LEVELS, ONE, ONE}};
+
+        auto make_node = [&](int level, std::uint64_t key)
+        {
+            auto it = level_states[level].find(key);
+            if (it != level_states[level].end())
+                return it->second;
+            int id = raw.size();
+            raw.push_back({level, ZERO, ZERO});
+            level_states[level].emplace(key, id);
+            level_keys[level].push_back(key);
+            return id;
+        };
+
+        int raw_root = make_node(0, 0);
+        std::array<int, 81> label;
+        std::array<bool, 81> dangling;
+        for (int i = 0; i < LEVELS; ++i)
+        {
+            const LevelEdge &e = order[i];
+            const std::vector<Node> &fr = frontier[i];
+            const std::vector<Node> &next_fr = frontier[i + 1];
+            bool in_f = base[e.id] != 0;
+
+            for (std::uint64_t key : level_keys[i])
+            {
+                int id = level_states[i][key];
+
+                // F の辺と、F を囲む長方形の外の辺は D に入れない
+                for (int take = 0; take < (in_f || !in_box[i] ? 1 : 2); ++take)
+                {
+                    // 状態を展開（次の段で新しく入る頂点は 0）
+                    for (Node w : next_fr)
+                    {
+                        label[w] = 0;
+                        dangling[w] = false;
+                    }
+                    for (size_t k = 0; k < fr.size(); ++k)
+                    {
+                        label[fr[k]] = (key >> (4 * k)) & 15;
+                        dangling[fr[k]] = (key >> (DANGLING_SHIFT + k)) & 1;
+                    }
+
+                    int weight = (key >> WEIGHT_SHIFT) + take;
+                    if (weight > extra_limit)
+                        continue;
+                    int child = next_state(e, in_f, take, weight, fr, next_fr, f_after[i + 1],
+                                           label, dangling, make_node, i + 1);
+                    if (take)
+                        raw[id].hi = child;
+                    else
+                        raw[id].lo = child;
+                }
+            }
+            level_states[i].clear();
+        }
+
+        reduce(raw, raw_root);
+    }
+
+    // 辺 e を F の辺として使う (in_f) / D に入れる (take) ときの次の節点
+    template <typename MakeNode>
+    int next_state(const LevelEdge &e, bool in_f, bool take, int weight,
+                   const std::vector<Node> &fr, const std::vector<Node> &next_fr,
+                   int f_remaining, std::array<int, 81> &label, std::array<bool, 81> &dangling,
+                   MakeNode &make_node, int next_level)
+    {
+        if (in_f || take)
+        {
+            int a = label[e.u], b = label[e.v];
+            if (take)
+            {
+                // 同じ成分の中に D の辺を足すと閉路になる
+                if (a != 0 && a == b)
+                    return ZERO;
+
+                // F の頂点でない端は、D の辺が1本だけなら行き止まり
+                for (Node w : {e.u, e.v})
+                {
+                    if (!is_f_vertex[w])
+                        dangling[w] = (label[w] == 0);
+                }
+            }
+
+            if (a == 0 && b == 0)
+            {
+                label[e.u] = label[e.v] = 15; // 新しい成分（後で番号を振り直す）
+            }
+            else if (a == 0)
+            {
+                label[e.u] = b;
+            }
+            else if (b == 0)
+            {
+                label[e.v] = a;
+            }
+            else if (a != b)
+            {
+                for (Node w : fr)
+                {
+                    if (label[w] == b)
+                        label[w] = a;
+                }
+            }
+        }
+
+        // フロンティアから出る頂点
+        std::array<bool, 81> stays{};
+        for (Node w : next_fr)
+            stays[w] = true;
+
+        // 行き止まりのまま出ていく頂点があれば最小にならない
+        for (Node w : fr)
+        {
+            if (!stays[w] && dangling[w])
+                return ZERO;
+        }
+
+        for (Node w : fr)
+        {
+            if (stays[w] || label[w] == 0)
+                continue;
+
+            // 成分が閉じるか
+            bool closed = true;
+            for (Node x : next_fr)
+            {
+                if (label[x] == label[w])
+                {
+                    closed = false;
+                    break;
+                }
+            }
+            if (!closed)
+                continue;
+
+            // 閉じた成分が最後の成分なら 1 終端、そうでなければ 0 終端
+            for (Node x : fr)
+            {
+                if (label[x] != 0 && label[x] != label[w])
+                    return ZERO;
+            }
+            return f_remaining == 0 ? ONE : ZERO;
+        }
+
+        if (next_level == LEVELS)
+            return ZERO;
+
+        // 番号を出てくる順に振り直して詰める
+        std::array<int, 16> renum{};
+        int next_label = 0;
+        std::uint64_t key = (std::uint64_t)weight << WEIGHT_SHIFT;
+        for (size_t k = 0; k < next_fr.size(); ++k)
+        {
+            int l = label[next_fr[k]];
+            if (l != 0)
+            {
+                if (renum[l] == 0)
+                    renum[l] = ++next_label;
+                l = renum[l];
+            }
+            key |= (std::uint64_t)l << (4 * k);
+            if (dangling[next_fr[k]])
+                key |= 1ULL << (DANGLING_SHIFT + k);
+        }
+        return make_node(next_level, key);
+    }
+
+    // hi が 0 終端の節点を取り除き、同じ子を持つ節点をまとめる
+    void reduce(const std::vector<DDNode> &raw, int raw_root)
+    {
+        std::vector<int> to(raw.size(), ZERO);
+        to[ONE] = ONE;
+        std::unordered_map<std::uint64_t, int> unique;
+        for (int id = (int)raw.size() - 1; id > ONE; --id)
+        {
+            int lo = to[raw[id].lo], hi = to[raw[id].hi];
+            if (hi == ZERO)
+            {
+                to[id] = lo;
+                continue;
+            }
+            std::uint64_t key = ((std::uint64_t)raw[id].level << 56) | ((std::uint64_t)lo << 28) | (std::uint64_t)hi;
+            auto it = unique.find(key);
+            if (it != unique.end())
+            {
+                to[id] = it->second;
+                continue;
+            }
+            to[id] = nodes.size();
+            nodes.push_back({raw[id].level, lo, hi});
+            unique.emplace(key, to[id]);
+        }
+        root = to[raw_root];
+    }
+
+    // 最小本数と、その本数で 1 終端に届く道の数（子は親より先に作られている）
+    void count_minimum()
+    {
+        min_weight.assign(nodes.size(), INF);
+        num.assign(nodes.size(), 0);
+        min_weight[ONE] = 0;
+        num[ONE] = 1;
+        for (size_t n = 2; n < nodes.size(); ++n)
+        {
+            const DDNode &d = nodes[n];
+            int lo = min_weight[d.lo];
+            int hi = min_weight[d.hi] == INF ? INF : min_weight[d.hi] + 1;
+            min_weight[n] = std::min(lo, hi);
+            if (min_weight[n] == INF)
+                continue;
+            std::uint64_t c = 0;
+            if (lo == min_weight[n])
+                c += num[d.lo];
+            if (hi == min_weight[n])
+                c = (c + num[d.hi] < c) ? std::numeric_limits<std::uint64_t>::max() : c + num[d.hi];
+            num[n] = c;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef DETOUR_SEARCH_HPP
+#define DETOUR_SEARCH_HPP
+
+// 境界の辺集合 F をすべて通る、ちょうど length 歩の閉じた歩き方を探す
+// EulerSolver は最短の歩き方（最短の橋と最小全域木）しか作らないが、
+// 最短のものが距離条件や折りの条件を満たさなくても、少し遠回りした
+// 32歩のループなら折れることがある。その遠回りを含めて探す
+//
+// 歩き方は、F の辺をちょうど1回、それ以外の辺を偶数回通り、
+// 来た辺をすぐに戻らない（Uターンしない）ものに限る
+// 奇数回通る辺の集合が F でなければ、折ったときの外形がドット絵と変わるため
+//
+// 始点を F の最小の頂点に固定し、1歩ずつ深さ優先で進める
+// 通る回数の偶奇がまだ合っていない辺（未通過の F の辺と、奇数回通った
+// F 以外の辺）は、残りの歩き方で必ず通るので、枝刈りには次の3つを使う
+//   - 残りの歩数の下界：偶奇の合っていない辺の本数
+//     ＋ 今の頂点からそれらの辺の連結成分をすべて回って始点に戻る道の長さ
+//     成分の中の移動を0とみなし、成分の間はマンハッタン距離の最小値で測る
+//     成分が多いときは、回る順番を決める代わりに最小全域木の重さで測る
+//   - 1歩で偶奇が変わる辺は1本なので、残りの歩数と偶奇の合っていない辺の
+//     本数の偶奇が一致する
+//   - 距離条件（32歩のループなら、条件を満たすズラシが残っているか）
+// 遠回りが長いと歩き方の数そのものが爆発するので、
+// length と始点での下界の差が max_detour を超える F は探さない
+// 得られた歩き方は EulerSolver::canonical_circuits で回転と反転をまとめる
+
+#include "EulerSolver.hpp"
+
+#include <array>
+#include <climits>
+#include <vector>
+
+class DetourSearch
+{
+public:
+    // 歩き方の長さ（外周のループは32歩）
+    int length = 32;
+
+    // 始点での下界より何歩まで長い歩き方を探すか
+    int max_detour = 4;
+
+    // 見つかった歩き方に最後にかける条件（距離条件は探索中に見る）
+    WalkConstraints constraints = WalkConstraints::loop_filter();
+
+    // 探索木を幅優先に展開する深さ（EulerSolver と同じ並列化）
+    int parallel_depth = 8;
+
+    // 探索した節点の数
+    long long visited = 0;
+
+    /**
+     * @brief F のすべての辺を通る length 歩の閉じた歩き方を探す
+     * @return 歩き方（頂点の列。末尾は先頭と同じ頂点）のリスト
+     */
+    std::vector<std::vector<Node>> search(const EdgeList &F)
+    {
+        visited = 0;
+        f_edges.clear();
+        is_f.fill(false);
+        for (const auto &e : F)
+        {
+            int id = grid_edge_id(e.first, e.second);
+            if (id < 0)
+                return {};
+            if (is_f[id])
+                continue;
+            is_f[id] = true;
+            f_edges.push_back(std::minmax(e.first, e.second));
+        }
+        if (f_edges.empty() || (int)f_edges.size() > length || length > 32)
+            return {};
+
+        Node start = 81;
+        for (const auto &e : f_edges)
+            start = std::min(start, e.first);
+
+        Walk root;
+        root.path[0] = start;
+        root.size = 1;
+        root.used.fill(0);
+        root.wrong = f_edges.size();
+        root.slides = ALL_SLIDES;
+        root.path_x[0] = start % 9;
+        root.path_y[0] = start / 9;
+        int bound = lower_bound(root);
+        if (bound > length || length - bound > max_detour)
+            return {};
+
+        // 探索木を展開して並列に探す
+        std::vector<Walk> frontier{root};
+        for (int d = 0; d < parallel_depth && d < length; ++d)
+        {
+            std::vector<Walk> expanded;
+            for (auto &w : frontier)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    Walk next = w;
+                    if (step(next, i))
+                        expanded.push_back(next);
+                }
+            }
+            frontier.swap(expanded);
+        }
+
+        int num_tasks = frontier.size();
+        std::vector<std::vector<std::vector<Node>>> task_walks(num_tasks);
+        long long count = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) reduction(+ : count)
+        for (int t = 0; t < num_tasks; ++t)
+            count += dfs(frontier[t], task_walks[t]);
+
+        visited += count;
+        std::vector<std::vector<Node>> walks;
+        for (auto &ws : task_walks)
+        {
+            for (auto &walk : ws)
+            {
+                if (odd_edges_are_f(walk))
+                    walks.push_back(std::move(walk));
+            }
+        }
+        return EulerSolver::canonical_circuits(walks, constraints);
+    }
+
+    /**
+     * @brief 閉じた歩き方 walk が F の辺をちょうど1回、それ以外の辺を偶数回通るか
+     * （奇数回通る辺の集合が F と一致し、折ったときの外形が変わらないか）
+     */
+    bool odd_edges_are_f(const std::vector<Node> &walk) const
+    {
+        EdgeCounts counts{};
+        for (size_t i = 0; i + 1 < walk.size(); ++i)
+        {
+            int e = grid_edge_id(walk[i], walk[i + 1]);
+            if (e < 0)
+                return false;
+            counts[e]++;
+        }
+        for (int e = 0; e < NUM_GRID_EDGES; ++e)
+        {
+            if (is_f[e] ? counts[e] != 1 : counts[e] % 2 != 0)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    std::vector<Edge> f_edges;
+    std::array<bool, NUM_GRID_EDGES> is_f;
+
+    static constexpr int dx[4] = {0, 0, 1, -1};
+    static constexpr int dy[4] = {1, -1, 0, 0};
+
+    // 回る順番をすべて試す成分の数の上限（それより多ければ最小全域木）
+    static constexpr int MAX_ORDERED_GROUPS = 8;
+
+    // 成分（F の辺は32本まで）と今の頂点・始点の間の距離
+    static constexpr int MAX_GROUPS = 34;
+    using Distances = std::array<int, MAX_GROUPS * MAX_GROUPS>;
+
+    // 固定長の配列だけで持ち、1歩ごとのコピーでメモリを確保しない
+    struct Walk
+    {
+        Node path[33];
+        int size;
+        EdgeCounts used;     // 辺を通った回数
+        int wrong;           // 通る回数の偶奇が合っていない辺の数
+        unsigned int slides; // 距離条件を満たしうるズラシの集合
+        int path_x[32], path_y[32];
+    };
+
+    static int manhattan(Node u, Node v)
+    {
+        return std::abs(u % 9 - v % 9) + std::abs(u / 9 - v / 9);
+    }
+
+    // 残りの歩数の下界
+    int lower_bound(const Walk &w) const
+    {
+        Node cur = w.path[w.size - 1];
+        Node start = w.path[0];
+        if (w.wrong == 0)
+            return manhattan(cur, start);
+        // 成分の数を MAX_GROUPS - 2 以下に抑える（どうせ枝刈りされる）
+        if (w.wrong > length)
+            return w.wrong;
+
+        // 偶奇の合っていない辺の連結成分を求める（81頂点なので配列の上で union-find）
+        // 未通過の F の辺と、これまでに通った F 以外の辺のうち奇数回のもの
+        std::array<Node, 81> parent;
+        std::array<bool, 81> touched{};
+        auto join = [&](Node u, Node v)
+        {
+            for (Node x : {u, v})
+            {
+                if (!touched[x])
+                {
+                    touched[x] = true;
+                    parent[x] = x;
+                }
+            }
+            Node a = root_of(parent, u);
+            Node b = root_of(parent, v);
+            parent[std::max(a, b)] = std::min(a, b);
+        };
+        for (const auto &e : f_edges)
+        {
+            if (w.used[grid_edge_id(e.first, e.second)] == 0)
+                join(e.first, e.second);
+        }
+        for (int i = 1; i < w.size; ++i)
+        {
+            int e = grid_edge_id(w.path[i - 1], w.path[i]);
+            if (!is_f[e] && w.used[e] % 2 != 0)
+                join(w.path[i - 1], w.path[i]);
+        }
+
+        // 成分の番号をつける（成分 k は今の頂点、k + 1 は始点）
+        std::array<int, 81> group;
+        group.fill(-1);
+        Node verts[81];
+        int num_verts = 0;
+        int k = 0;
+        for (Node v = 0; v < 81; ++v)
+        {
+            if (!touched[v])
+                continue;
+            Node r = root_of(parent, v);
+            if (group[r] < 0)
+                group[r] = k++;
+            group[v] = group[r];
+            verts[num_verts++] = v;
+        }
+        int n = k + 2;
+        Distances d;
+        std::fill(d.begin(), d.begin() + n * n, INT_MAX);
+        for (int a = 0; a < n; ++a)
+            d[a * n + a] = 0;
+        auto relax = [&](int a, int b, int dist)
+        {
+            if (dist < d[a * n + b])
+                d[a * n + b] = d[b * n + a] = dist;
+        };
+        for (int i = 0; i < num_verts; ++i)
+        {
+            int a = group[verts[i]];
+            for (int j = i + 1; j < num_verts; ++j)
+            {
+                int b = group[verts[j]];
+                if (a != b)
+                    relax(a, b, manhattan(verts[i], verts[j]));
+            }
+            relax(a, k, manhattan(verts[i], cur));
+            relax(a, k + 1, manhattan(verts[i], start));
+        }
+        relax(k, k + 1, manhattan(cur, start));
+
+        int rest = k <= MAX_ORDERED_GROUPS ? shortest_tour(d, k) : spanning_tree(d, n);
+        return w.wrong + rest;
+    }
+
+    static Node root_of(std::array<Node, 81> &parent, Node v)
+    {
+        while (parent[v] != v)
+            v = parent[v] = parent[parent[v]];
+        return v;
+    }
+
+    // 成分 k から成分 0..k-1 をすべて回って成分 k + 1 に着く道の最短の長さ
+    // 成分の中を通り抜ける移動も許すので、距離を最短路で閉じてから順番を決める
+    static int shortest_tour(Distances &d, int k)
+    {
+        int n = k + 2;
+        for (int m = 0; m < n; ++m)
+            for (int a = 0; a < n; ++a)
+                for (int b = 0; b < n; ++b)
+                    d[a * n + b] = std::min(d[a * n + b], d[a * n + m] + d[m * n + b]);
+
+        // dp[S][i] : 今の頂点から集合 S の成分を回って成分 i にいる最短の長さ
+        int full = (1 << k) - 1;
+        std::array<int, (1 << MAX_ORDERED_GROUPS) * MAX_ORDERED_GROUPS> dp;
+        std::fill(dp.begin(), dp.begin() + (full + 1) * k, INT_MAX);
+        for (int i = 0; i < k; ++i)
+            dp[(1 << i) * k + i] = d[k * n + i];
+        for (int s = 1; s <= full; ++s)
+        {
+            for (int i = 0; i < k; ++i)
+            {
+                int cost = dp[s * k + i];
+                if (cost == INT_MAX)
+                    continue;
+                for (int j = 0; j < k; ++j)
+                {
+                    if (s >> j & 1)
+                        continue;
+                    int &next = dp[(s | 1 << j) * k + j];
+                    next = std::min(next, cost + d[i * n + j]);
+                }
+            }
+        }
+        int best = INT_MAX;
+        for (int i = 0; i < k; ++i)
+            best = std::min(best, dp[full * k + i] + d[i * n + k + 1]);
+        return best;
+    }
+
+    // 成分の最小全域木の重さ（Prim 法）
+    static int spanning_tree(const Distances &d, int n)
+    {
+        int best[MAX_GROUPS];
+        bool done[MAX_GROUPS];
+        std::fill(best, best + n, INT_MAX);
+        std::fill(done, done + n, false);
+        best[0] = 0;
+        int total = 0;
+        for (int t = 0; t < n; ++t)
+        {
+            int a = -1;
+            for (int i = 0; i < n; ++i)
+            {
+                if (!done[i] && (a < 0 || best[i] < best[a]))
+                    a = i;
+            }
+            done[a] = true;
+            total += best[a];
+            for (int i = 0; i < n; ++i)
+            {
+                if (!done[i])
+                    best[i] = std::min(best[i], d[a * n + i]);
+            }
+        }
+        return total;
+    }
+
+    // 歩み w を方向 i に1歩進める。枝刈りされたら false
+    bool step(Walk &w, int i) const
+    {
+        Node u = w.path[w.size - 1];
+        int nx = u % 9 + dx[i];
+        int ny = u / 9 + dy[i];
+        if (nx < 0 || nx >= 9 || ny < 0 || ny >= 9)
+            return false;
+        int pos = w.size;
+        if (pos > length)
+            return false;
+
+        Node v = ny * 9 + nx;
+
+        // 来た辺をすぐに戻らない
+        if (w.size >= 2 && v == w.path[w.size - 2])
+            return false;
+
+        // F の辺は1回だけ通る。それ以外の辺は通るたびに偶奇が変わる
+        int e = grid_edge_id(u, v);
+        if (is_f[e])
+        {
+            if (w.used[e] != 0)
+                return false;
+            w.used[e] = 1;
+            w.wrong--;
+        }
+        else
+        {
+            w.wrong += ++w.used[e] % 2 != 0 ? 1 : -1;
+        }
+        w.path[w.size++] = v;
+
+        // 残りの歩数で偶奇の合っていない辺をすべて通れるか
+        int rest = length - pos;
+        if (w.wrong > rest || (rest - w.wrong) % 2 != 0)
+            return false;
+
+        // 距離条件（最後の1歩は始点に戻るので見ない）
+        if (length == 32 && constraints.distance && pos < 32)
+        {
+            w.path_x[pos] = nx;
+            w.path_y[pos] = ny;
+            w.slides = update_slides(w.slides, pos, w.path_x, w.path_y);
+            if (w.slides == 0)
+                return false;
+        }
+
+        // 残りの歩数で F を回りきって戻れるか
+        return lower_bound(w) <= rest;
+    }
+
+    // 1歩ずつ進めて length 歩で始点に戻る歩き方を集める。探索した節点の数を返す
+    long long dfs(const Walk &w, std::vector<std::vector<Node>> &walks) const
+    {
+        long long count = 1;
+        if (w.size == length + 1)
+        {
+            // 始点に戻ったところでもUターンしない
+            if (w.wrong == 0 && w.path[length] == w.path[0] &&
+                w.path[1] != w.path[length - 1])
+                walks.emplace_back(w.path, w.path + w.size);
+            return count;
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            Walk next = w;
+            if (step(next, i))
+                count += dfs(next, walks);
+        }
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,1041 @@
+#ifndef EULER_SOLVER_HPP
+#define EULER_SOLVER_HPP
+
+// 境界の辺集合を、すべての辺を通る最短の閉じた歩き方にする
+// 連結成分を最短の橋で繋ぎ（橋は往復で2回通る）、できたグラフの一筆書きを列挙する
+// shortest_euler_walk.exe と solve_non_connect.exe から使う
+
+#include "ComponentDistances.hpp"
+#include "distanceConstraint.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// --- 1. Common Types ---
+using Node = int;
+using Edge = std::pair<Node, Node>;
+using EdgeList = std::vector<Edge>;
+
+// --- 2. PathManager ---
+
+// 2点間の最短経路（各歩で X, Y 方向のどちらへ進むか）をビット列で表す
+// bit i が 0 なら i 歩目は X 方向、1 なら Y 方向に進む。列の長さは2点の距離
+// 経路はいつも番号の小さい頂点から大きい頂点へ向かって辿る
+using Moves = std::uint32_t;
+
+class PathManager
+{
+private:
+    static constexpr int width = 9;
+    static constexpr int V = 81;
+    static constexpr int MAX_LEN = 16; // 9x9 グリッドの2点間の最大距離
+
+    // binom[n][r] : 二項係数
+    std::array<std::array<int, MAX_LEN + 1>, MAX_LEN + 1> binom;
+
+    // path_count[u * 81 + v] : u, v 間の最短経路の数
+    std::vector<int> path_count;
+
+    // 経路の向き（u < v に正規化）と X, Y 方向の歩数
+    struct Span
+    {
+        Node from, to;
+        int nx, ny;
+    };
+
+    Span span(Node start, Node target) const
+    {
+        Node u = std::min(start, target);
+        Node v = std::max(start, target);
+        return {u, v, std::abs(u % width - v % width), std::abs(u / width - v / width)};
+    }
+
+public:
+    PathManager() : path_count(V * V)
+    {
+        for (int n = 0; n <= MAX_LEN; ++n)
+        {
+            for (int r = 0; r <= MAX_LEN; ++r)
+            {
+                if (r > n)
+                    binom[n][r] = 0;
+                else if (r == 0 || r == n)
+                    binom[n][r] = 1;
+                else
+                    binom[n][r] = binom[n - 1][r - 1] + binom[n - 1][r];
+            }
+        }
+        for (Node u = 0; u < V; ++u)
+        {
+            for (Node v = 0; v < V; ++v)
+            {
+                Span s = span(u, v);
+                path_count[u * V + v] = binom[s.nx + s.ny][s.nx];
+            }
+        }
+    }
+
+    // マンハッタン距離を計算
+    int get_dist(Node u, Node v) const
+    {
+        int x1 = u % width;
+        int y1 = u / width;
+        int x2 = v % width;
+        int y2 = v / width;
+        return std::abs(x1 - x2) + std::abs(y1 - y2);
+    }
+
+    // 2点間の最短経路の数
+    int count_shortest_paths(Node start, Node target) const
+    {
+        return path_count[start * V + target];
+    }
+
+    // k 番目 (0 <= k < count_shortest_paths) の最短経路
+    // 順序は「X 方向を先に選ぶ」辞書順
+    Moves unrank(Node start, Node target, int k) const
+    {
+        Span s = span(start, target);
+        int nx = s.nx, ny = s.ny;
+        Moves m = 0;
+        for (int i = 0; nx + ny > 0; ++i)
+        {
+            // 次を X 方向にしたときの経路の数
+            int with_x = (nx > 0) ? binom[nx - 1 + ny][ny] : 0;
+            if (k < with_x)
+            {
+                nx--;
+            }
+            else
+            {
+                k -= with_x;
+                m |= Moves(1) << i;
+                ny--;
+            }
+        }
+        return m;
+    }
+
+    // unrank の逆
+    int rank(Node start, Node target, Moves m) const
+    {
+        Span s = span(start, target);
+        int nx = s.nx, ny = s.ny;
+        int k = 0;
+        for (int i = 0; nx + ny > 0; ++i)
+        {
+            if ((m >> i) & 1)
+            {
+                k += (nx > 0) ? binom[nx - 1 + ny][ny] : 0;
+                ny--;
+            }
+            else
+            {
+                nx--;
+            }
+        }
+        return k;
+    }
+
+    // 経路 m の辺を1本ずつ f(小さい頂点, 大きい頂点) に渡す
+    template <typename F>
+    void for_each_edge(Node start, Node target, Moves m, F &&f) const
+    {
+        Span s = span(start, target);
+        int step_x = (s.to % width > s.from % width) ? 1 : -1;
+        int step_y = (s.to / width > s.from / width) ? width : -width;
+        Node curr = s.from;
+        for (int i = 0; i < s.nx + s.ny; ++i)
+        {
+            Node next = curr + (((m >> i) & 1) ? step_y : step_x);
+            f(std::min(curr, next), std::max(curr, next));
+            curr = next;
+        }
+    }
+
+    // 2点間の最短経路を順に1つずつ作る（全体を保持しない）
+    class PathRange
+    {
+    private:
+        const PathManager *pm;
+        Node start, target;
+        int n;
+
+    public:
+        class iterator
+        {
+        private:
+            const PathRange *range;
+            int k;
+
+        public:
+            iterator(const PathRange *r, int k) : range(r), k(k) {}
+            Moves operator*() const { return range->pm->unrank(range->start, range->target, k); }
+            iterator &operator++()
+            {
+                ++k;
+                return *this;
+            }
+            bool operator!=(const iterator &o) const { return k != o.k; }
+        };
+
+        PathRange(const PathManager *pm, Node start, Node target)
+            : pm(pm), start(start), target(target), n(pm->count_shortest_paths(start, target)) {}
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, n); }
+        int size() const { return n; }
+    };
+
+    PathRange shortest_paths(Node start, Node target) const
+    {
+        return PathRange(this, start, target);
+    }
+};
+
+// --- 3. ComponentManager ---
+
+class UnionFind
+{
+private:
+    std::vector<int> parent;
+    std::vector<int> rank;
+    int num_sets; // 連結成分の数
+
+public:
+    // nは頂点数（9x9なら81）
+    UnionFind(int n) : parent(n), rank(n, 0), num_sets(n)
+    {
+        // 最初は全頂点が自分自身を親（独立した集合）とする
+        std::iota(parent.begin(), parent.end(), 0);
+    }
+
+    // どの集合に属しているか（代表元）を探す
+    int find(int i)
+    {
+        if (parent[i] == i)
+            return i;
+        // 経路圧縮：探索ついでに親を代表元に直接繋ぎ直す
+        return parent[i] = find(parent[i]);
+    }
+
+    // 2つの集合を合併する
+    bool unite(int i, int j)
+    {
+        int root_i = find(i);
+        int root_j = find(j);
+
+        if (root_i != root_j)
+        {
+            // ランク（木の高さ）が低い方を高い方に繋ぐ
+            if (rank[root_i] < rank[root_j])
+            {
+                parent[root_i] = root_j;
+            }
+            else
+            {
+                parent[root_j] = root_i;
+                if (rank[root_i] == rank[root_j])
+                    rank[root_i]++;
+            }
+            num_sets--; // 合併したので集合の数が減る
+            return true;
+        }
+        return false;
+    }
+
+    // 同じ集合に属しているか判定
+    bool same(int i, int j)
+    {
+        return find(i) == find(j);
+    }
+
+    // 現在の独立した集合の数を返す
+    int count() const
+    {
+        return num_sets;
+    }
+};
+
+struct Component
+{
+    int id;
+    std::vector<Node> nodes;
+    EdgeList edges;
+};
+
+struct Bridge
+{
+    int comp1_id, comp2_id;
+    int dist;
+    std::vector<std::pair<Node, Node>> best_pairs;
+};
+
+// MSTの結果を保持する構造体
+struct MSTFramework
+{
+    std::vector<int> bridge_indices; // 使うBridgeのid
+    int total_dist;
+};
+
+class ComponentManager
+{
+public:
+    // 辺集合Fから連結成分を抽出する
+    std::vector<Component> extract_components(const EdgeList &F)
+    {
+        if (F.empty())
+            return {};
+
+        // 1. Fに含まれる全頂点を特定
+        std::set<Node> node_set;
+        for (const auto &e : F)
+        {
+            node_set.insert(e.first);
+            node_set.insert(e.second);
+        }
+
+        // 2. Union-Findで連結判定
+        UnionFind uf(81);
+        for (const auto &e : F)
+        {
+            uf.unite(e.first, e.second);
+        }
+
+        // 3. 代表元ごとに頂点と辺をグループ化
+        std::map<int, std::vector<Node>> group_nodes;
+        for (Node v : node_set)
+        {
+            group_nodes[uf.find(v)].push_back(v);
+        }
+
+        std::map<int, EdgeList> group_edges;
+        for (const auto &e : F)
+        {
+            group_edges[uf.find(e.first)].push_back(e);
+        }
+
+        // 4. Component構造体のリストに変換
+        std::vector<Component> components;
+        int comp_id = 0;
+        for (const auto &[root, nodes] : group_nodes)
+        {
+            components.push_back({comp_id++, nodes, group_edges[root]});
+        }
+
+        return components;
+    }
+
+    // コンポーネント間の全ペアについて最短距離と頂点ペアを計算する
+    // 距離は ComponentDistances の距離場から一度にまとめて求める
+    std::vector<Bridge> compute_all_bridges(const std::vector<Component> &comps)
+    {
+        std::vector<std::vector<Node>> nodes;
+        for (const auto &c : comps)
+            nodes.push_back(c.nodes);
+        ComponentDistances cd(9, 9, nodes);
+
+        std::vector<Bridge> bridges;
+        int n = comps.size();
+
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = i + 1; j < n; ++j)
+            {
+                Bridge bridge;
+                bridge.comp1_id = comps[i].id;
+                bridge.comp2_id = comps[j].id;
+                bridge.dist = cd.dist(i, j);
+                bridge.best_pairs = cd.best_pairs(i, j);
+                bridges.push_back(bridge);
+            }
+        }
+        return bridges;
+    }
+
+    // 最小全域木となる橋の選び方をすべて返す
+    // Kruskal 法で、長さの等しい橋をまとめて1つの段として扱い、
+    // 各段で「それまでの森に閉路を作らず、できるだけ多くの成分をつなぐ」
+    // 橋の選び方をすべて試す（どの最小全域木もこの形で一度ずつ現れる）
+    // 結果の順序は、橋の組み合わせを next_permutation で総当たりしたときと同じ
+    std::vector<MSTFramework> find_all_msts(const std::vector<Bridge> &bridges, int num_comps)
+    {
+        if (num_comps <= 1)
+            return {{{}, 0}}; // すでに連結
+
+        // 橋を長さの順に並べ、長さの等しいものを1つの段にまとめる
+        std::vector<int> order(bridges.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+                         { return bridges[a].dist < bridges[b].dist; });
+
+        std::vector<std::vector<int>> groups;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            if (i == 0 || bridges[order[i]].dist != bridges[order[i - 1]].dist)
+                groups.emplace_back();
+            groups.back().push_back(order[i]);
+        }
+
+        std::vector<MSTFramework> results;
+        std::vector<int> chosen;
+        enumerate_groups(0, bridges, groups, UnionFind(num_comps), chosen, 0, results);
+
+        // 橋の番号の昇順に並べ、総当たりのときと同じ順序にそろえる
+        // （番号の小さい側から見て、最初に違う橋を含まない方が先）
+        for (auto &mst : results)
+            std::sort(mst.bridge_indices.begin(), mst.bridge_indices.end());
+        int n = bridges.size();
+        std::sort(results.begin(), results.end(), [n](const MSTFramework &a, const MSTFramework &b)
+                  {
+                      std::vector<char> fa(n, 0), fb(n, 0);
+                      for (int i : a.bridge_indices)
+                          fa[i] = 1;
+                      for (int i : b.bridge_indices)
+                          fb[i] = 1;
+                      return fa < fb; });
+        return results;
+    }
+
+private:
+    // 段 g 以降の橋の選び方を列挙する
+    void enumerate_groups(
+        size_t g,
+        const std::vector<Bridge> &bridges,
+        const std::vector<std::vector<int>> &groups,
+        UnionFind uf,
+        std::vector<int> &chosen,
+        int total_dist,
+        std::vector<MSTFramework> &results)
+    {
+        if (uf.count() == 1 || g == groups.size())
+        {
+            if (uf.count() == 1)
+                results.push_back({chosen, total_dist});
+            return;
+        }
+
+        // この段で新たにつなげる成分の数（段の橋をすべて架けてみて数える）
+        UnionFind trial = uf;
+        int need = 0;
+        for (int b : groups[g])
+        {
+            if (trial.unite(bridges[b].comp1_id, bridges[b].comp2_id))
+                need++;
+        }
+
+        choose_in_group(g, 0, need, bridges, groups, uf, chosen, total_dist, results);
+    }
+
+    // 段 g の pos 番目以降の橋から、閉路を作らない need 本を選ぶ
+    void choose_in_group(
+        size_t g,
+        size_t pos,
+        int need,
+        const std::vector<Bridge> &bridges,
+        const std::vector<std::vector<int>> &groups,
+        UnionFind &uf,
+        std::vector<int> &chosen,
+        int total_dist,
+        std::vector<MSTFramework> &results)
+    {
+        const std::vector<int> &group = groups[g];
+        if (need == 0)
+        {
+            enumerate_groups(g + 1, bridges, groups, uf, chosen, total_dist, results);
+            return;
+        }
+        if (group.size() - pos < (size_t)need)
+            return;
+
+        int b = group[pos];
+
+        // この橋を架ける
+        if (!uf.same(bridges[b].comp1_id, bridges[b].comp2_id))
+        {
+            UnionFind next = uf;
+            next.unite(bridges[b].comp1_id, bridges[b].comp2_id);
+            chosen.push_back(b);
+            choose_in_group(g, pos + 1, need - 1, bridges, groups, next, chosen, total_dist + bridges[b].dist, results);
+            chosen.pop_back();
+        }
+
+        // この橋を架けない
+        choose_in_group(g, pos + 1, need, bridges, groups, uf, chosen, total_dist, results);
+    }
+};
+
+// --- 4. EulerSolver ---
+
+// 9x9グリッドの辺の番号（BoundaryGraph の EdgeMask と同じ）
+//   横の辺 (x, y)-(x+1, y) は y * 8 + x、縦の辺 (x, y)-(x, y+1) は 72 + x * 8 + y
+constexpr int NUM_GRID_EDGES = 144;
+
+// 隣り合う2頂点の間の辺の番号（隣り合っていなければ -1）
+inline int grid_edge_id(Node u, Node v)
+{
+    if (u > v)
+        std::swap(u, v);
+    if (u < 0 || v >= 81)
+        return -1;
+    if (v == u + 1 && u % 9 != 8)
+        return (u / 9) * 8 + u % 9;
+    if (v == u + 9)
+        return 72 + (u % 9) * 8 + u / 9;
+    return -1;
+}
+
+// 各辺の使用回数を辺の番号で引く表
+using EdgeCounts = std::array<std::uint8_t, NUM_GRID_EDGES>;
+
+// 一筆書きを作りながら判定する条件
+// path_filter の条件（PathFilter.hpp）を探索の途中で使えるようにしたもの
+// 条件を満たさない歩き方はその時点で枝刈りし、結果に含めない
+struct WalkConstraints
+{
+    // この歩数の歩き方だけを探す（0 なら制限しない）
+    int length = 0;
+
+    // 32歩のループなら、距離条件を満たすズラシが無くなった時点で枝刈りする
+    bool distance = true;
+
+    // 十字路を縦と横に直進して交差しない
+    bool turn_at_crossings = false;
+
+    // 右折が左折より4回多い（どちらかの向きで時計回りに一周する）
+    bool clockwise = false;
+
+    // path_filter と同じ条件（外周の32歩のループとして使えるもの）
+    static WalkConstraints loop_filter()
+    {
+        WalkConstraints c;
+        c.length = 32;
+        c.distance = true;
+        c.turn_at_crossings = true;
+        c.clockwise = true;
+        return c;
+    }
+};
+
+class EulerSolver
+{
+public:
+    // 最終結果の保存先
+    std::vector<std::vector<Node>> all_solutions;
+
+    // 探索中に判定する条件
+    WalkConstraints constraints;
+
+    // 歩数が constraints.length と違うため、一筆書きを探さなかった辺の使い方の数
+    int skipped_by_length = 0;
+
+private:
+    // 32歩のループなら、距離条件を満たすズラシが無くなった時点で枝刈りする
+    bool prune_distance = false;
+
+    // 十字路での直進を探索中に判定する
+    // 判定は回路の始点によって変わるので、始点を1度しか通らず、
+    // 出力する回路（canonicalize 後）と同じ並びになるときだけ使う
+    bool prune_crossings = false;
+
+    // 一筆書きの探索途中の状態
+    struct Walk
+    {
+        EdgeCounts counts;          // 辺の残り通過可能回数
+        std::vector<Node> path;     // 現在までの歩みの記録（頂点のリスト）
+        int remaining_edges;        // 残りの総辺数
+        unsigned int slides;        // 距離条件を満たしうるズラシの集合（8bit）
+        int path_x[32], path_y[32]; // ループの位置ごとの頂点の座標
+
+        // 頂点ごとの直前の通り方（0 : 曲がった / 未通過、1 : 縦に直進、2 : 横に直進）
+        std::array<std::int8_t, 81> straight_dir;
+    };
+
+    // 一歩進んだときの状態の変化
+    struct Step
+    {
+        Node v;              // 進んだ先の頂点
+        int e;               // 通る辺
+        unsigned int slides; // 進んだ後に距離条件を満たしうるズラシの集合
+        int dir;             // 今いる頂点の通り方（straight_dir と同じ値）
+    };
+
+    // 9x9グリッドの上下左右
+    static constexpr int dx[4] = {0, 0, 1, -1};
+    static constexpr int dy[4] = {1, -1, 0, 0};
+
+public:
+    // 一筆書きの探索を並列化するとき、探索木を幅優先に展開する深さ
+    // 展開した途中までの歩みをそれぞれ1つのタスクとしてスレッドに割り振る
+    int parallel_depth = 8;
+
+    // 処理の開始
+    void solve(const EdgeList &F,
+               const std::vector<MSTFramework> &msts,
+               const std::vector<Bridge> &bridges,
+               const PathManager &pm)
+    {
+
+        // 過去の探索結果をクリア
+        all_solutions.clear();
+        skipped_by_length = 0;
+
+        // 1. 辺の番号ごとにカウント1でベースの表に登録
+        //    格子の辺でないものがあれば一筆書きはできない
+        EdgeCounts base_counts{};
+        for (const auto &e : F)
+        {
+            int id = grid_edge_id(e.first, e.second);
+            if (id < 0)
+                return;
+            base_counts[id]++;
+        }
+
+        // 2.見つかっている最短のMSTパターン（橋の架け方）を一つずつ試す
+        for (const auto &mst : msts)
+        {
+            // この中で「どの最短経路を通るか」を決める次の再帰へ
+            generate_variations(0, mst, bridges, pm, base_counts);
+        }
+
+        // 3. 同じ回路の回転と反転をまとめる
+        remove_duplicate_circuits();
+    }
+
+    // 辺の使用回数がすでに決まっているグラフ（CoverDiagram が列挙したものなど）の
+    // 一筆書きをまとめて探す
+    void solve(const std::vector<EdgeCounts> &covers)
+    {
+        all_solutions.clear();
+        skipped_by_length = 0;
+        for (const auto &counts : covers)
+            find_circuits_from(counts);
+        remove_duplicate_circuits();
+    }
+
+private:
+    // すべての橋について具体的な経路を選ぶ &
+    // 得られたグラフについて実際の歩き方を探す
+    void generate_variations(
+        int bridge_idx,
+        const MSTFramework &mst,
+        const std::vector<Bridge> &bridges,
+        const PathManager &pm,
+        EdgeCounts &current_counts)
+    {
+
+        // 全ての「橋」について具体的な経路を選び終わった場合
+        if (bridge_idx == mst.bridge_indices.size())
+        {
+            find_circuits_from(current_counts);
+            return;
+        }
+
+        // まだ選んでいない「橋」を取り出す
+        int b_idx = mst.bridge_indices[bridge_idx];
+        const Bridge &bridge = bridges[b_idx];
+
+        // その橋を実現する「頂点ペア」をすべて試す
+        for (const auto &p : bridge.best_pairs)
+        {
+            // そのペア間の「最短経路」をすべて試す（経路は1つずつ作る）
+            for (Moves path : pm.shortest_paths(p.first, p.second))
+            {
+                // 最短経路を「往復分」追加 (+2)
+                pm.for_each_edge(p.first, p.second, path, [&](Node u, Node v)
+                                 { current_counts[grid_edge_id(u, v)] += 2; });
+
+                // 次の橋の経路を選びに進む
+                generate_variations(bridge_idx + 1, mst, bridges, pm, current_counts);
+
+                // 探索が終わったら元に戻す
+                pm.for_each_edge(p.first, p.second, path, [&](Node u, Node v)
+                                 { current_counts[grid_edge_id(u, v)] -= 2; });
+            }
+        }
+    }
+
+    // 辺の使用回数 counts のグラフの一筆書き（閉路）を探し、all_solutions に追加する
+    void find_circuits_from(const EdgeCounts &counts)
+    {
+        // どこから歩き始めても閉路なので、辺を持つ最小の頂点から開始する
+        // 延べ何歩歩く必要があるかも数える
+        Node start_node = 81;
+        int total_steps = 0;
+        for (int id = 0; id < NUM_GRID_EDGES; id++)
+        {
+            if (counts[id] == 0)
+                continue;
+            total_steps += counts[id];
+            Node u = (id < 72) ? (id / 8) * 9 + id % 8 : ((id - 72) % 8) * 9 + (id - 72) / 8;
+            start_node = std::min(start_node, u);
+        }
+        if (total_steps == 0)
+            return;
+        if (constraints.length != 0 && total_steps != constraints.length)
+        {
+            skipped_by_length++;
+            return;
+        }
+
+        Walk walk;
+        walk.counts = counts;
+        walk.path.push_back(start_node);
+        walk.remaining_edges = total_steps;
+        walk.slides = ALL_SLIDES;
+        walk.path_x[0] = start_node % 9;
+        walk.path_y[0] = start_node / 9;
+        walk.straight_dir.fill(0);
+        prune_distance = constraints.distance && (total_steps == 32);
+
+        // 始点の次数が2なら始点は1度しか通らない
+        int start_degree = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            int id = grid_edge_id(start_node, start_node + dx[i] + dy[i] * 9);
+            if (id >= 0)
+                start_degree += counts[id];
+        }
+        prune_crossings = constraints.turn_at_crossings && start_degree == 2;
+
+        find_circuits_parallel(walk);
+    }
+
+    /**
+     * @brief 歩み w の現在の頂点から方向 i へ進めるかを調べる
+     * @param step 進んだときの状態の変化
+     */
+    bool can_step(Walk &w, int i, Step &step) const
+    {
+        Node u = w.path.back();
+        int nx = u % 9 + dx[i];
+        int ny = u / 9 + dy[i];
+        if (nx < 0 || nx >= 9 || ny < 0 || ny >= 9)
+            return false;
+
+        Node v = ny * 9 + nx;
+        step.v = v;
+        step.e = grid_edge_id(u, v);
+
+        // その道がまだ通れる（カウントが残っている）か
+        if (w.counts[step.e] == 0)
+            return false;
+
+        // v をループの位置 pos に置いても距離条件を満たすズラシが残るか
+        step.slides = w.slides;
+        int pos = (int)w.path.size();
+        if (prune_distance && pos < 32)
+        {
+            w.path_x[pos] = nx;
+            w.path_y[pos] = ny;
+            step.slides = update_slides(w.slides, pos, w.path_x, w.path_y);
+            if (step.slides == 0)
+                return false;
+        }
+
+        // u での通り方が決まるので、直前に u を通ったときと縦横が食い違えば交差する
+        // （始点での通り方は比べる相手がいないので見ない）
+        step.dir = 0;
+        if (prune_crossings && pos >= 2)
+        {
+            Node prev = w.path[pos - 2];
+            int dx1 = u % 9 - prev % 9, dy1 = u / 9 - prev / 9;
+            if (dx1 * dy[i] - dy1 * dx[i] == 0)
+                step.dir = (dx[i] == 0) ? 1 : 2;
+            int last = w.straight_dir[u];
+            if (last != 0 && step.dir != 0 && last != step.dir)
+                return false;
+        }
+        return true;
+    }
+
+    // 歩み w を step だけ進める。戻すときのために u の直前の通り方を返す
+    int apply_step(Walk &w, const Step &step) const
+    {
+        Node u = w.path.back();
+        int last = w.straight_dir[u];
+        if (prune_crossings && w.path.size() >= 2)
+            w.straight_dir[u] = step.dir;
+        w.counts[step.e]--;
+        w.path.push_back(step.v);
+        w.remaining_edges--;
+        w.slides = step.slides;
+        return last;
+    }
+
+    // 閉じた歩み（末尾は先頭と同じ頂点）が閉じたときの条件を満たすか
+    bool closes_clockwise(const std::vector<Node> &path) const
+    {
+        if (!constraints.clockwise)
+            return true;
+        std::vector<Node> loop(path.begin(), path.end() - 1);
+        return std::abs(turn_balance(loop)) == 4;
+    }
+
+    /**
+     * @brief 探索木を parallel_depth 歩まで幅優先に展開し、途中までの歩みごとに
+     *        並列にオイラー回路を探索する
+     *        展開は方向の順を保つので、タスクの順に結果をつなげると
+     *        逐次に探索したときと同じ順になる
+     */
+    void find_circuits_parallel(const Walk &root)
+    {
+        std::vector<Walk> frontier{root};
+        for (int d = 0; d < parallel_depth; ++d)
+        {
+            std::vector<Walk> expanded;
+            bool grown = false;
+            for (auto &w : frontier)
+            {
+                // すべての辺を使い切った歩みはそのまま残す
+                if (w.remaining_edges == 0)
+                {
+                    expanded.push_back(w);
+                    continue;
+                }
+                for (int i = 0; i < 4; ++i)
+                {
+                    Step step;
+                    if (!can_step(w, i, step))
+                        continue;
+
+                    Walk next = w;
+                    apply_step(next, step);
+                    expanded.push_back(std::move(next));
+                    grown = true;
+                }
+            }
+            frontier.swap(expanded);
+            if (!grown)
+                break;
+        }
+
+        int num_tasks = frontier.size();
+        std::vector<std::vector<std::vector<Node>>> task_solutions(num_tasks);
+
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int t = 0; t < num_tasks; ++t)
+            find_circuits(frontier[t], task_solutions[t]);
+
+        for (auto &solutions : task_solutions)
+            all_solutions.insert(all_solutions.end(), solutions.begin(), solutions.end());
+    }
+
+    /**
+     * @brief オイラー回路（一筆書き）をバックトラッキングで探索する
+     * @param w 現在の歩み（書き換えながら探索）
+     * @param solutions 見つかった回路の保存先
+     */
+    void find_circuits(Walk &w, std::vector<std::vector<Node>> &solutions) const
+    {
+        // 全ての辺を使い切った場合
+        if (w.remaining_edges == 0)
+        {
+            if (closes_clockwise(w.path))
+                solutions.push_back(w.path);
+            return;
+        }
+
+        // 現在の頂点に接続している辺をすべて調べる
+        // ※ 9x9グリッドなので、上下左右の隣接ノードを直接チェックするのが速い
+        for (int i = 0; i < 4; ++i)
+        {
+            Step step;
+            if (!can_step(w, i, step))
+                continue;
+
+            // 1. 進む
+            unsigned int slides = w.slides;
+            int last = apply_step(w, step);
+
+            // 2. 次の地点で再帰探索
+            find_circuits(w, solutions);
+
+            // 3. 戻る（バックトラッキング：状態を復元）
+            w.slides = slides;
+            w.remaining_edges++;
+            w.path.pop_back();
+            w.counts[step.e]++;
+            w.straight_dir[w.path.back()] = last;
+        }
+    }
+
+    // 閉じた歩き方（末尾の重複を除いた頂点の列）の右折の数 - 左折の数
+    static int turn_balance(const std::vector<Node> &c)
+    {
+        int n = (int)c.size();
+        int balance = 0;
+        for (int i = 0; i < n; i++)
+        {
+            Node prev = c[(i + n - 1) % n], curr = c[i], next = c[(i + 1) % n];
+            int dx1 = curr % 9 - prev % 9, dy1 = curr / 9 - prev / 9;
+            int dx2 = next % 9 - curr % 9, dy2 = next / 9 - curr / 9;
+            int cross = dx1 * dy2 - dy1 * dx2;
+            if (cross > 0)
+                balance++;
+            else if (cross < 0)
+                balance--;
+        }
+        return balance;
+    }
+
+    // 閉じた歩き方（末尾の重複を除いた頂点の列）が十字路で曲がっているか
+    // 先頭から順に、同じ頂点を直前に通ったときと縦横の直進が食い違えば false
+    // （path_filter の must_turn_at_intersection と同じ判定）
+    static bool turns_at_crossings(const std::vector<Node> &c)
+    {
+        int n = (int)c.size();
+        std::array<int, 81> last{};
+        for (int i = 0; i < n; i++)
+        {
+            Node prev = c[(i + n - 1) % n], curr = c[i], next = c[(i + 1) % n];
+            int dir = 0;
+            if (prev % 9 == curr % 9 && curr % 9 == next % 9)
+                dir = 1;
+            if (prev / 9 == curr / 9 && curr / 9 == next / 9)
+                dir = 2;
+            if (last[curr] != 0 && dir != 0 && last[curr] != dir)
+                return false;
+            last[curr] = dir;
+        }
+        return true;
+    }
+
+    // 頂点の列を回転させたもののうち辞書順で最小のもの
+    static std::vector<Node> minimal_rotation(const std::vector<Node> &c)
+    {
+        std::vector<Node> best = c, r = c;
+        for (size_t k = 1; k < c.size(); k++)
+        {
+            std::rotate(r.begin(), r.begin() + 1, r.end());
+            if (r < best)
+                best = r;
+        }
+        return best;
+    }
+
+    /**
+     * @brief 回転（始点の違い）と反転（向きの違い）で同じになる回路を1つにまとめる
+     *
+     * 回転と反転をすべて試した中で辞書順最小の列を回路の代表として比べ、
+     * 最初に見つかった順に残す
+     * 残す回路は右折が左折以上になる向き（右回り）にそろえ、
+     * 辞書順最小の回転から始める（末尾に先頭と同じ頂点を付け直す）
+     * 十字路の条件は始点によって変わるので、そろえた後の回路で判定し直す
+     */
+    void remove_duplicate_circuits()
+    {
+        all_solutions = canonical_circuits(all_solutions, constraints);
+    }
+
+public:
+    // remove_duplicate_circuits の本体
+    // 閉じた歩き方の列 walks の回転と反転をまとめ、条件 c の十字路と右左折の判定をする
+    static std::vector<std::vector<Node>> canonical_circuits(const std::vector<std::vector<Node>> &walks,
+                                                             const WalkConstraints &c)
+    {
+        std::set<std::vector<Node>> seen;
+        std::vector<std::vector<Node>> unique_solutions;
+        for (auto walk : walks)
+        {
+            if (walk.size() > 1 && walk.front() == walk.back())
+                walk.pop_back();
+
+            std::vector<Node> forward = minimal_rotation(walk);
+            std::reverse(walk.begin(), walk.end());
+            std::vector<Node> backward = minimal_rotation(walk);
+            if (!seen.insert(std::min(forward, backward)).second)
+                continue;
+
+            int balance = turn_balance(forward);
+            std::vector<Node> circuit;
+            if (balance > 0)
+                circuit = forward;
+            else if (balance < 0)
+                circuit = backward;
+            else
+                circuit = std::min(forward, backward);
+            if (c.clockwise && std::abs(balance) != 4)
+                continue;
+            if (c.turn_at_crossings && !turns_at_crossings(circuit))
+                continue;
+            circuit.push_back(circuit.front());
+            unique_solutions.push_back(std::move(circuit));
+        }
+        return unique_solutions;
+    }
+
+    /**
+     * @brief 探索されたすべての解をテキストファイルに書き出す
+     * @param filename 出力ファイル名
+     */
+    void save_solutions_to_file(const std::string &filename)
+    {
+        std::ofstream ofs(filename);
+
+        if (!ofs)
+        {
+            std::cerr << "Error: Cannot open file for writing: " << filename << std::endl;
+            return;
+        }
+
+        for (auto &walk : all_solutions)
+        {
+            if (!walk.empty() && walk.front() == walk.back())
+            {
+                walk.pop_back();
+            }
+
+            for (size_t i = 0; i < walk.size(); ++i)
+            {
+                ofs << walk[i] << (i == walk.size() - 1 ? "" : " ");
+            }
+            ofs << "\n";
+        }
+
+        std::cout << "Successfully saved " << all_solutions.size() << " solutions to " << filename << std::endl;
+    }
+};
+
+/**
+ * @brief 辺集合 F のすべての辺を通る最短の閉じた歩き方をすべて求める
+ * @param F 境界の辺集合
+ * @param constraints 探索中に判定する条件（満たさない歩き方は含めない）
+ * @param skipped_by_length 歩数が constraints.length と違うため探さなかった辺の使い方の数（nullptr なら返さない）
+ * @return 歩き方（頂点の列。末尾は先頭と同じ頂点）のリスト
+ */
+inline std::vector<std::vector<Node>> find_shortest_walks(const EdgeList &F,
+                                                          const WalkConstraints &constraints = WalkConstraints(),
+                                                          int *skipped_by_length = nullptr)
+{
+    if (skipped_by_length != nullptr)
+        *skipped_by_length = 0;
+    if (F.empty())
+        return {};
+
+    PathManager pm;
+    ComponentManager cm;
+    EulerSolver solver;
+    solver.constraints = constraints;
+
+    auto comps = cm.extract_components(F);
+    auto bridges = cm.compute_all_bridges(comps);
+    auto msts = cm.find_all_msts(bridges, comps.size());
+    solver.solve(F, msts, bridges, pm);
+
+    if (skipped_by_length != nullptr)
+        *skipped_by_length = solver.skipped_by_length;
+    return solver.all_solutions;
+}
+
+#endif
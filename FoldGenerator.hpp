@@ -0,0 +1,200 @@
+#ifndef FOLD_GENERATOR_HPP
+#define FOLD_GENERATOR_HPP
+
+// 外周のループ（曲がり方の列）から、外周32か所の折り割当を列挙する
+// solve_non_connect.exe から使う
+
+#include <map>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "packedLoop.h"
+
+using FoldAssignment = std::vector<int>;
+
+class FoldGenerator
+{
+    // 紙の表裏
+    static constexpr int FRONT = 1;
+    static constexpr int BACK = 0;
+
+    // 曲がる向き
+    static constexpr int L = -1;
+    static constexpr int S = 0;
+    static constexpr int R = 1;
+    static constexpr int X = 2;
+
+    // --- NGリスト ---
+    static inline const std::vector<std::vector<int>> NG_LIST = {
+        {0, 8, 4},
+        {0, 8, 6},
+        {4, 8, 4},
+        {4, 8, 6},
+        {6, 8, 4},
+        {6, 8, 6},
+        {1, 8, 0},
+        {1, 8, 1},
+        {1, 8, 3},
+        {3, 8, 0},
+        {3, 8, 1},
+        {3, 8, 3},
+        {3, 4},
+        {3, 6}};
+
+public:
+    static bool has_NG_words(std::vector<int> v)
+    {
+        if (v.size() == 32)
+        {
+            v.push_back(v[0]);
+        }
+
+        for (auto ng : NG_LIST)
+        {
+            if (v.size() < ng.size())
+                continue;
+
+            bool flag = true;
+            for (int i = 0; i < ng.size(); i++)
+            {
+                int n = ng[ng.size() - 1 - i];
+                int m = v[v.size() - 1 - i];
+                if (m != n)
+                {
+                    flag = false;
+                    break;
+                }
+            }
+            if (flag)
+                return true;
+        }
+
+        return false;
+    }
+
+    static std::vector<int> toInt(const std::string &s)
+    {
+        std::map<char, int> ctoi = {{'S', S}, {'R', R}, {'L', L}, {'X', X}};
+        std::vector<int> ans;
+        for (char c : s)
+            ans.push_back(ctoi.at(c));
+        return ans;
+    }
+
+    // LRS形式から折り割当に変換する関数
+    static std::vector<std::vector<int>> LRtoNum2(const std::string &input_str)
+    {
+
+        // 8の倍数番目の文字がSなら不適
+        if (input_str[0] == 'S' || input_str[8] == 'S' || input_str[16] == 'S' || input_str[24] == 'S')
+            return std::vector<std::vector<int>>();
+
+        // LRSからなる入力文字列を-1,0,1の列に変換
+        std::vector<int> lrint = toInt(input_str);
+
+        // ここでは配列のインデックスとして使いたいため1を加算
+        for (int i = 0; i < lrint.size(); i++)
+        {
+            lrint[i] += 1;
+        }
+
+        // 紙の表裏を決定
+        int side = (lrint[0] == R + 1) ? FRONT : BACK;
+
+        // 向きと折り番号の対応
+        std::vector<int> fold_table[2][3];
+        fold_table[FRONT][S + 1] = {0};
+        fold_table[FRONT][L + 1] = {4};
+        fold_table[FRONT][R + 1] = {1, 3, 6};
+        fold_table[BACK][S + 1] = {0};
+        fold_table[BACK][R + 1] = {4};
+        fold_table[BACK][L + 1] = {1, 3, 6};
+
+        // 表裏が入れ替わるかどうか
+        std::map<int, int> flip_map;
+        flip_map[0] = 0; // 折り方0番は裏返らない
+        flip_map[1] = 1;
+        flip_map[3] = 0;
+        flip_map[4] = 1;
+        flip_map[6] = 0;
+        flip_map[8] = 0;
+
+        // --- NGリスト ---
+        // "084", "086", "484", "486", "684", "686",
+        // "180", "181", "183", "380", "381", "383" : 折れない
+        // "34", "36" : 折れるが同値な折り方が存在する
+
+        // --- 探索処理 ---
+
+        std::vector<std::vector<int>> answers;
+
+        struct Node
+        {
+            int side;
+            std::vector<int> folds;
+        };
+
+        std::stack<Node> stk;
+        stk.push({side, {}});
+
+        while (!stk.empty())
+        {
+            Node node = stk.top();
+            stk.pop();
+
+            // 終了処理
+            if (node.folds.size() == 32)
+            {
+                if (has_NG_words(node.folds))
+                    continue;
+
+                answers.push_back(node.folds);
+                continue;
+            }
+
+            // 8の倍数の処理
+            if (node.folds.size() % 8 == 0)
+            {
+                int lr = lrint[node.folds.size()];
+                if (node.side == BACK && lr == R + 1)
+                    continue;
+                if (node.side == FRONT && lr == L + 1)
+                    continue;
+
+                node.folds.push_back(8);
+                stk.push(node);
+                continue;
+            }
+
+            // 一般の処理
+
+            for (auto f : fold_table[node.side][lrint[node.folds.size()]])
+            {
+                std::vector<int> new_folds = node.folds;
+                new_folds.push_back(f);
+
+                if (has_NG_words(new_folds))
+                    continue;
+
+                stk.push({(node.side + flip_map[f]) % 2, new_folds});
+            }
+        }
+
+        return answers;
+    }
+
+    // ループの列から折り割当を生成する
+    static std::vector<FoldAssignment> generate(const std::vector<PackedLoop> &loops)
+    {
+        std::vector<FoldAssignment> all_folds;
+        for (const PackedLoop &loop : loops)
+        {
+            std::vector<std::vector<int>> folds = LRtoNum2(loop.turn_string());
+            all_folds.insert(all_folds.end(), folds.begin(), folds.end());
+        }
+        return all_folds;
+    }
+};
+
+#endif
@@ -3,6 +3,9 @@ import subprocess
 import sys
 from tkinter import messagebox
 
+# 実行ファイルの拡張子（Linux では build.sh で拡張子なしの実行ファイルを作る）
+EXE_SUFFIX = ".exe" if os.name == "nt" else ""
+
 
 # 行列Aの全要素を足し合わせる
 # Aは二次元配列
@@ -60,7 +63,7 @@ class Model:
 
         # 平坦折り可能なタイル配置を探すスクリプトを実行する
         script_dir = os.path.dirname(os.path.abspath(__file__))
-        target_script = os.path.join(script_dir, "dotToGraph.exe")
+        target_script = os.path.join(script_dir, "dotToGraph" + EXE_SUFFIX)
         head = [target_script, "-mode=findCP", dotstr, str(speed)]
 
         print("speed: " + str(speed))
@@ -101,7 +104,7 @@ class Model:
 
         # 平坦折り可能なタイル配置を探すスクリプトを実行する
         script_dir = os.path.dirname(os.path.abspath(__file__))
-        target_script = os.path.join(script_dir, "solve_non_connect.exe")
+        target_script = os.path.join(script_dir, "solve_non_connect" + EXE_SUFFIX)
 
         print("target_script: " + target_script)
 
@@ -151,7 +154,7 @@ class Model:
 
         # ループ長を計算するスクリプトを実行する
         script_dir = os.path.dirname(os.path.abspath(__file__))
-        target_script = os.path.join(script_dir, "dotToGraph.exe")
+        target_script = os.path.join(script_dir, "dotToGraph" + EXE_SUFFIX)
         head = [target_script, "-mode=calcLength", dotstr]
 
         result_str = subprocess.check_output(head, text=True, encoding="utf-8")
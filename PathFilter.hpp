@@ -1,27 +1,139 @@
 #ifndef PATH_FILTER_HPP
 #define PATH_FILTER_HPP
 
+// 最短の歩き方のうち、外周のループとして使えるものだけを残す
+//   1. 十字路で曲がっている
+//   2. 右折が左折より4回多い（時計回りに一周する）
+//   3. 8通りの回転のどれかで距離条件を満たす（最初に満たす回転を残す）
+// path_filter.exe と solve_non_connect.exe から使う
+
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <fstream>
+#include <sstream>
+
+#include "loopKernels.h"
+#include "packedLoop.h"
 
 using Node = int;
 using Path = std::vector<Node>;
 
 class PathFilter
 {
-    std::vector<Path> all_paths;
-    std::vector<Path> filtered_paths;
-
-    bool must_turn_at_intersection(const Path &path);
-    bool has_right_turns_excess_4(const Path &path);
-    bool check_distance_constraint(const Path &path);
-    Path rotate_path(const Path &path, int offset);
+    std::vector<PackedLoop> all_paths;
+    std::vector<PackedLoop> filtered_paths;
+    int skipped_count = 0; // 32歩でないため読み飛ばした歩き方の数
 
 public:
-    void load_path();
-    void filter();
+    // --- フチの交差判定 ---
+    // 曲がり方のワードのビット演算で判定する（loopKernels.h）
+    static bool must_turn_at_intersection(const PackedLoop &path)
+    {
+        return turns_at_crossings(path);
+    }
+
+    // 時計回りで一周するかを判定する
+    // 右折が左折より4回多いことを判定
+    static bool has_right_turns_excess_4(const PackedLoop &path)
+    {
+        return turns_clockwise(path);
+    }
+
+    // 距離制約判定 (先頭がカド固定)
+    // 展開図上の距離は distanceConstraint.h の表をコンパイル時に作ってあり、
+    // 8通りのズラシをまとめて判定できる（loopKernels.h）
+    static bool check_distance_constraint(const PackedLoop &path)
+    {
+        return satisfies_distance(path);
+    }
+
+    // 歩き方の列を読み込む
+    // 32歩のループになっていないものは読み飛ばし、その数を数える
+    void load_path(const std::vector<Path> &walks)
+    {
+        all_paths.clear();
+        skipped_count = 0;
+        for (const auto &walk : walks)
+        {
+            PackedLoop loop;
+            if (PackedLoop::pack(walk, loop))
+                all_paths.push_back(loop);
+            else
+                skipped_count++;
+        }
+    }
+
+    // ファイルから歩き方を読み込む（1行に1つ、頂点番号を空白区切り）
+    // ファイルが開けなければ false を返す
+    bool load_path(const std::string &filename)
+    {
+        all_paths.clear();
+        skipped_count = 0;
+        std::ifstream ifs(filename);
+        if (!ifs)
+            return false;
+
+        std::string line;
+        Path path;
+        while (std::getline(ifs, line))
+        {
+            if (line.empty())
+                continue;
+            path.clear();
+            std::stringstream ss(line);
+            Node n;
+            while (ss >> n)
+                path.push_back(n);
+
+            PackedLoop loop;
+            if (PackedLoop::pack(path, loop))
+                all_paths.push_back(loop);
+            else
+                skipped_count++;
+        }
+        return true;
+    }
+
+    // 判定に合格したループを、条件を満たす最初の回転にして残す
+    void filter()
+    {
+        filtered_paths.clear();
+        for (const auto &original_path : all_paths)
+        {
+            // 1. 基本形状のフィルタ（十字路、右左折）
+            if (!must_turn_at_intersection(original_path))
+                continue;
+            if (!has_right_turns_excess_4(original_path))
+                continue;
+
+            // 2. 8通りの回転について距離制約をまとめてチェックする
+            unsigned int slides = feasible_slides(original_path);
+            if (slides != 0)
+                filtered_paths.push_back(original_path.rotated(__builtin_ctz(slides)));
+        }
+    }
+
+    // 残ったループを1行に1つ書き出す
+    bool save_path(const std::string &filename) const
+    {
+        std::ofstream ofs(filename);
+        if (!ofs)
+            return false;
+        for (const auto &loop : filtered_paths)
+        {
+            for (int i = 0; i < PackedLoop::LENGTH; ++i)
+            {
+                ofs << loop.node(i) << (i == PackedLoop::LENGTH - 1 ? "" : " ");
+            }
+            ofs << "\n";
+        }
+        return true;
+    }
+
+    const std::vector<PackedLoop> &get_all_paths() const { return all_paths; }
+    const std::vector<PackedLoop> &get_filtered_paths() const { return filtered_paths; }
+    int get_skipped_count() const { return skipped_count; }
 };
 
-#endif
\ No newline at end of file
+#endif
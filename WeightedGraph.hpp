@@ -2,6 +2,7 @@
 #define WEIGHTED_GRAPH_H
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <vector>
 
@@ -14,17 +15,71 @@ struct Edge
     Edge(int t, int w) : to(t), weight(w) {}
 };
 
+// 頂点から出る辺の並び（CSR の一部を指す）
+struct EdgeRange
+{
+    const Edge *first;
+    const Edge *last;
+
+    const Edge *begin() const { return first; }
+    const Edge *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+// オイラー回路を1つずつ受け取る関数。false を返すと列挙をやめる
+using CircuitSink = std::function<bool(const std::vector<int> &)>;
+
 // 重み付きグラフクラス (整数重み・無向グラフ)
+// 隣接は CSR（頂点ごとの辺を1本の配列に並べたもの）で持つ
+// 辺を追加したあと最初に隣接を参照したときに、追加された順のまま並べ直す
 class WeightedGraph
 {
 private:
-    int V;                              // 頂点数
-    std::vector<std::vector<Edge>> adj; // 隣接リスト
+    int V; // 頂点数
+
+    // 追加された無向辺
+    std::vector<int> edgeFrom, edgeTo, edgeWeight;
+
+    // 頂点 u の辺は csrEdges[csrOffset[u]] から csrEdges[csrOffset[u + 1] - 1]
+    // csrId はその辺がどの無向辺か（向きの違う2本で同じ番号）
+    mutable bool csrDirty = true;
+    mutable std::vector<int> csrOffset;
+    mutable std::vector<Edge> csrEdges;
+    mutable std::vector<int> csrId;
+
+    void buildCSR() const
+    {
+        if (!csrDirty)
+            return;
+        csrOffset.assign(V + 1, 0);
+        for (size_t i = 0; i < edgeFrom.size(); ++i)
+        {
+            csrOffset[edgeFrom[i] + 1]++;
+            csrOffset[edgeTo[i] + 1]++;
+        }
+        for (int u = 0; u < V; ++u)
+            csrOffset[u + 1] += csrOffset[u];
+
+        std::vector<int> fill(csrOffset.begin(), csrOffset.end() - 1);
+        csrEdges.assign(csrOffset[V], Edge(0, 0));
+        csrId.assign(csrOffset[V], 0);
+        for (size_t i = 0; i < edgeFrom.size(); ++i)
+        {
+            int a = fill[edgeFrom[i]]++;
+            csrEdges[a] = Edge(edgeTo[i], edgeWeight[i]);
+            csrId[a] = i;
+            int b = fill[edgeTo[i]]++;
+            csrEdges[b] = Edge(edgeFrom[i], edgeWeight[i]);
+            csrId[b] = i;
+        }
+        csrDirty = false;
+    }
 
 public:
     // コンストラクタ
     // vertices: 頂点数
-    WeightedGraph(int vertices) : V(vertices) { adj.resize(vertices); }
+    WeightedGraph(int vertices) : V(vertices) {}
 
     // 辺の追加
     void addEdge(int u, int v, int w)
@@ -33,13 +88,20 @@ public:
         if (u < 0 || u >= V || v < 0 || v >= V)
             return;
 
-        adj[u].emplace_back(v, w);
-        // 無向グラフなので逆方向の辺も追加
-        adj[v].emplace_back(u, w);
+        // 無向グラフなので、隣接には両方向の辺が入る
+        edgeFrom.push_back(u);
+        edgeTo.push_back(v);
+        edgeWeight.push_back(w);
+        csrDirty = true;
     }
 
     // 指定した頂点から出る辺のリストを取得
-    const std::vector<Edge> &getNeighbors(int u) const { return adj[u]; }
+    EdgeRange getNeighbors(int u) const
+    {
+        buildCSR();
+        const Edge *base = csrEdges.data();
+        return {base + csrOffset[u], base + csrOffset[u + 1]};
+    }
 
     // 頂点数の取得
     int getVertexCount() const { return V; }
@@ -50,7 +112,7 @@ public:
         for (int i = 0; i < V; ++i)
         {
             std::cout << i << ":";
-            for (const auto &e : adj[i])
+            for (const auto &e : getNeighbors(i))
             {
                 std::cout << " -> " << e.to << "(" << e.weight << ")";
             }
@@ -66,7 +128,7 @@ public:
         // 重みが正の辺を持つ最初の頂点を探す
         for (int i = 0; i < V; ++i)
         {
-            for (const auto &e : adj[i])
+            for (const auto &e : getNeighbors(i))
             {
                 if (e.weight > 0)
                 {
@@ -93,7 +155,7 @@ public:
         while (head < (int)q.size())
         {
             int u = q[head++];
-            for (const auto &e : adj[u])
+            for (const auto &e : getNeighbors(u))
             {
                 if (e.weight > 0)
                 {
@@ -110,7 +172,7 @@ public:
         for (int i = 0; i < V; ++i)
         {
             bool hasPositiveEdge = false;
-            for (const auto &e : adj[i])
+            for (const auto &e : getNeighbors(i))
             {
                 if (e.weight > 0)
                 {
@@ -130,69 +192,84 @@ public:
     }
 
     // すべての辺をその重みの回数分通って、元の場所に戻ってくる方法（オイラー回路）を列挙する
-    std::vector<std::vector<int>> findAllEulerianCircuits(int startNode = 0)
+    std::vector<std::vector<int>> findAllEulerianCircuits(int startNode = 0) const
     {
         std::vector<std::vector<int>> results;
+        forEachEulerianCircuit(startNode, [&](const std::vector<int> &path)
+                               { results.push_back(path); return true; });
+        return results;
+    }
+
+    // オイラー回路を見つけた順に sink に渡す（path は次の回路で上書きされる）
+    // maxCount が正なら、その数だけ渡したところでやめる
+    // 渡した回路の数を返す
+    long long forEachEulerianCircuit(int startNode, const CircuitSink &sink,
+                                     long long maxCount = 0) const
+    {
+        buildCSR();
 
         long long totalWeight = 0;
         for (int i = 0; i < V; ++i)
         {
             long long degree = 0;
-            for (const auto &e : adj[i])
+            for (const auto &e : getNeighbors(i))
             {
                 degree += e.weight;
             }
             if (degree % 2 != 0)
             {
-                return results; // 次数が奇数の頂点がある場合、オイラー回路は存在しない
+                return 0; // 次数が奇数の頂点がある場合、オイラー回路は存在しない
             }
             totalWeight += degree;
         }
         totalWeight /= 2;
 
-        std::vector<std::vector<Edge>> currentAdj = adj;
-        std::vector<int> path;
-        path.reserve(totalWeight + 1);
-        path.push_back(startNode);
+        // 無向辺ごとの残りの回数（両方向で共有するので、逆向きの辺を探さなくてよい）
+        EulerState state{std::vector<int>(edgeWeight), {}, sink, maxCount, 0, false};
+        state.path.reserve(totalWeight + 1);
+        state.path.push_back(startNode);
 
-        dfsEuler(startNode, totalWeight, path, currentAdj, results);
+        dfsEuler(startNode, totalWeight, state);
 
-        return results;
+        return state.found;
     }
 
 private:
-    void dfsEuler(int u, long long edgesLeft, std::vector<int> &path,
-                  std::vector<std::vector<Edge>> &currentAdj,
-                  std::vector<std::vector<int>> &results)
+    struct EulerState
+    {
+        std::vector<int> remaining; // 無向辺ごとの残りの回数
+        std::vector<int> path;
+        const CircuitSink &sink;
+        long long maxCount;
+        long long found;
+        bool stopped;
+    };
+
+    void dfsEuler(int u, long long edgesLeft, EulerState &state) const
     {
         if (edgesLeft == 0)
         {
-            if (u == path[0])
+            if (u == state.path[0])
             {
-                results.push_back(path); // ここで現在の path のコピーが保存されます
+                state.found++;
+                if (!state.sink(state.path) ||
+                    (state.maxCount > 0 && state.found >= state.maxCount))
+                    state.stopped = true;
             }
             return;
         }
 
-        for (auto &e : currentAdj[u])
+        for (int i = csrOffset[u]; i < csrOffset[u + 1] && !state.stopped; ++i)
         {
-            if (e.weight > 0)
+            int &left = state.remaining[csrId[i]];
+            if (left > 0)
             {
-                int v = e.to;
-                e.weight--;
-                for (auto &revE : currentAdj[v])
-                {
-                    if (revE.to == u && revE.weight > 0)
-                    {
-                        revE.weight--;
-                        path.push_back(v); // 経路を進める
-                        dfsEuler(v, edgesLeft - 1, path, currentAdj, results);
-                        path.pop_back(); // バックトラック：探索から戻ったら状態を元に戻す
-                        revE.weight++;
-                        break; // 1つの逆辺だけを戻す
-                    }
-                }
-                e.weight++;
+                int v = csrEdges[i].to;
+                left--;
+                state.path.push_back(v); // 経路を進める
+                dfsEuler(v, edgesLeft - 1, state);
+                state.path.pop_back(); // バックトラック：探索から戻ったら状態を元に戻す
+                left++;
             }
         }
     }
@@ -1,6 +1,7 @@
 #ifndef WEIGHTED_GRID_GRAPH_HPP
 #define WEIGHTED_GRID_GRAPH_HPP
 
+#include "ComponentDistances.hpp"
 #include "WeightedGraph.hpp"
 #include <algorithm>
 #include <cmath>
@@ -207,26 +208,13 @@ public:
         };
         std::vector<CompEdge> compEdges; // 全成分間のペアに対する距離リスト
 
+        // 成分間の距離は距離場からまとめて求める
+        ComponentDistances cd(width, height, components);
         for (int i = 0; i < k; ++i)
         {
             for (int j = i + 1; j < k; ++j)
             {
-                int minDist = 1000000000;
-                // 成分 i と 成分 j の間の最短距離を総当たりで計算
-                for (int u : components[i])
-                {
-                    int ux = u % width;
-                    int uy = u / width;
-                    for (int v : components[j])
-                    {
-                        int vx = v % width;
-                        int vy = v / width;
-                        int d = std::abs(ux - vx) + std::abs(uy - vy);
-                        if (d < minDist)
-                            minDist = d;
-                    }
-                }
-                compEdges.push_back({i, j, minDist});
+                compEdges.push_back({i, j, cd.dist(i, j)});
             }
         }
 
@@ -329,30 +317,14 @@ public:
         };
         std::vector<CompEdge> compEdges;
 
+        // 最短の頂点ペアは、総当たりで最初に見つかるもの（best_pairs の先頭）を使う
+        ComponentDistances cd(width, height, components);
         for (int i = 0; i < k; ++i)
         {
             for (int j = i + 1; j < k; ++j)
             {
-                int minDist = 1000000000;
-                int bestU = -1, bestV = -1;
-                for (int u : components[i])
-                {
-                    int ux = u % width;
-                    int uy = u / width;
-                    for (int v : components[j])
-                    {
-                        int vx = v % width;
-                        int vy = v / width;
-                        int d = std::abs(ux - vx) + std::abs(uy - vy);
-                        if (d < minDist)
-                        {
-                            minDist = d;
-                            bestU = u;
-                            bestV = v;
-                        }
-                    }
-                }
-                compEdges.push_back({i, j, bestU, bestV, minDist});
+                const auto &best = cd.best_pairs(i, j).front();
+                compEdges.push_back({i, j, best.first, best.second, cd.dist(i, j)});
             }
         }
 
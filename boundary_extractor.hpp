@@ -5,12 +5,14 @@
 #include <string>
 #include <stdexcept>
 #include <fstream>
+#include <utility>
 
-struct Edge
+// 境界の辺。EulerSolver.hpp の Edge（頂点の組）と同じ翻訳単位で使えるように名前を分けてある
+struct BoundaryEdge
 {
     int u, v;
     // 重複判定などのために比較演算子があると便利
-    bool operator==(const Edge &other) const
+    bool operator==(const BoundaryEdge &other) const
     {
         return (u == other.u && v == other.v) || (u == other.v && v == other.u);
     }
@@ -19,14 +21,14 @@ struct Edge
 class BoundaryExtractor
 {
 public:
-    static std::vector<Edge> extract(const std::string &bitmap)
+    static std::vector<BoundaryEdge> extract(const std::string &bitmap)
     {
         if (bitmap.length() != 64)
         {
             throw std::invalid_argument("Bitmap must be exactly 64 characters.");
         }
 
-        std::vector<Edge> edges;
+        std::vector<BoundaryEdge> edges;
         auto get_node = [](int x, int y)
         { return y * 9 + x; };
 
@@ -55,7 +57,7 @@ public:
     }
 
     // オイラー閉路が存在するか（次数チェック）の簡易バリデーション
-    static bool is_eulerian(const std::vector<Edge> &edges)
+    static bool is_eulerian(const std::vector<BoundaryEdge> &edges)
     {
         if (edges.empty())
             return false;
@@ -73,10 +75,21 @@ public:
         return true;
     }
 
+    // 辺を頂点の組の列として返す（EulerSolver.hpp の EdgeList と同じ形）
+    static std::vector<std::pair<int, int>> extract_pairs(const std::string &bitmap)
+    {
+        std::vector<std::pair<int, int>> pairs;
+        for (const auto &e : extract(bitmap))
+        {
+            pairs.push_back({e.u, e.v});
+        }
+        return pairs;
+    }
+
     // 2. 指定されたファイル名にエッジ形式で保存する機能
     static void save_as_edges(const std::string &bitmap, const std::string &filename)
     {
-        std::vector<Edge> edges = extract(bitmap);
+        std::vector<BoundaryEdge> edges = extract(bitmap);
 
         std::ofstream ofs(filename);
         if (!ofs)
@@ -0,0 +1,131 @@
+#pragma once
+
+// 固定長のリングバッファによる、複数の書き手と複数の読み手の間のキュー
+//
+// 各スロットに番号 (sequence) を持たせ、書き手は enqueue_pos、読み手は
+// dequeue_pos を compare_exchange で進めてスロットを確保する（ロックを使わない）
+// スロットの番号が
+//   pos     : 空で、pos 番目の書き込みを待っている
+//   pos + 1 : pos 番目の値が入っていて、読み出しを待っている
+// を表す
+//
+// try_push / try_pop は待たずに失敗を返す
+// push / pop は空き・値ができるまで譲りながら待つので、後段が詰まっていれば
+// 前段はそこで止まる（背圧）
+// 書き手がすべて close すると、pop は空になった時点で false を返す
+// cancel すると push / pop はすぐに false を返す
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T> class BoundedQueue {
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t mask;
+
+    // 書き手と読み手の位置は別のキャッシュラインに置く
+    alignas(64) std::atomic<std::size_t> enqueue_pos{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos{0};
+    alignas(64) std::atomic<int> open_producers;
+    std::atomic<bool> cancelled{false};
+
+  public:
+    // capacity は2の冪に切り上げる
+    BoundedQueue(std::size_t capacity, int producers = 1)
+        : open_producers(producers) {
+        std::size_t n = 2;
+        while (n < capacity)
+            n <<= 1;
+        slots = std::vector<Slot>(n);
+        for (std::size_t i = 0; i < n; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        mask = n - 1;
+    }
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    bool try_push(T &value) {
+        std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 満杯
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T &value) {
+        std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff =
+                (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.value);
+                    slot.sequence.store(pos + mask + 1,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 空
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 空きができるまで待って入れる。cancel されたら false
+    bool push(T value) {
+        while (!try_push(value)) {
+            if (is_cancelled())
+                return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // 値ができるまで待って取り出す
+    // 書き手がすべて close して空になったか、cancel されたら false
+    bool pop(T &value) {
+        for (;;) {
+            if (is_cancelled())
+                return false;
+            if (try_pop(value))
+                return true;
+            if (open_producers.load(std::memory_order_acquire) == 0) {
+                // close の直前に入った値を取りこぼさないようにもう一度見る
+                return try_pop(value);
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // 書き手の1つが書き終えた
+    void close() { open_producers.fetch_sub(1, std::memory_order_acq_rel); }
+
+    void cancel() { cancelled.store(true, std::memory_order_release); }
+    bool is_cancelled() const {
+        return cancelled.load(std::memory_order_acquire);
+    }
+};
@@ -1,6 +1,6 @@
 @echo off
 echo Compiling...
-g++ .\dotToGraph.cpp .\BoundaryGraph.cpp .\loopToFolds.cpp .\foldsToEdges.cpp .\ftcp.cpp -O3 -fopenmp -lpsapi -o dotToGraph.exe
+g++ .\dotToGraph.cpp .\BoundaryGraph.cpp .\loopToFolds.cpp .\loopSolver.cpp .\foldsToEdges.cpp .\foldPrefilter.cpp .\foldNogood.cpp .\interiorOracle.cpp .\cpPipeline.cpp .\dotPrefilter.cpp .\resultCache.cpp .\ftcp.cpp -O3 -fopenmp -lpsapi -o dotToGraph.exe
 if %errorlevel% neq 0 exit /b %errorlevel%
 echo Build successful. Running...
 .\dotToGraph.exe
\ No newline at end of file
@@ -0,0 +1,7 @@
+#!/bin/sh
+# Linux 用の build.bat
+set -e
+echo Compiling...
+g++ dotToGraph.cpp BoundaryGraph.cpp loopToFolds.cpp loopSolver.cpp foldsToEdges.cpp foldPrefilter.cpp foldNogood.cpp interiorOracle.cpp cpPipeline.cpp dotPrefilter.cpp resultCache.cpp ftcp.cpp -O3 -fopenmp -o dotToGraph
+echo Build successful. Running...
+./dotToGraph
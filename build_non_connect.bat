@@ -1 +1 @@
-g++ solve_non_connect.cpp foldsToEdges.cpp boundary_extractor.hpp ftcp.cpp -fopenmp -O3 -o solve_non_connect.exe
\ No newline at end of file
+g++ solve_non_connect.cpp foldsToEdges.cpp foldPrefilter.cpp foldNogood.cpp interiorOracle.cpp ftcp.cpp -fopenmp -O3 -o solve_non_connect.exe
\ No newline at end of file
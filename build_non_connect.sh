@@ -0,0 +1,3 @@
+#!/bin/sh
+# Linux 用の build_non_connect.bat
+g++ solve_non_connect.cpp foldsToEdges.cpp foldPrefilter.cpp foldNogood.cpp interiorOracle.cpp ftcp.cpp -fopenmp -O3 -o solve_non_connect
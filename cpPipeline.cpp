@@ -0,0 +1,165 @@
+#include "cpPipeline.h"
+
+#include "boundedQueue.h"
+#include "foldNogood.h"
+#include "foldPrefilter.h"
+#include "foldsToEdges.h"
+#include "ftcp.h"
+#include "interiorOracle.h"
+#include "loopKernels.h"
+#include "packedLoop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// S, R, L, X のマクロを定義するので最後に読み込む
+#include "loopToFolds.h"
+
+using namespace std;
+
+CPPipeline::Result CPPipeline::run(BoundaryGraph &bg) {
+    auto start = chrono::steady_clock::now();
+    auto elapsed_ms = [start]() {
+        return (long long)chrono::duration_cast<chrono::milliseconds>(
+                   chrono::steady_clock::now() - start)
+            .count();
+    };
+
+    // ループの列挙に1つ、絞り込みと折り割り当ての生成に指定した数のスレッドを
+    // 使い、残りのコアでDPを回す
+    int num_dp = dp_threads;
+    if (num_dp <= 0) {
+        int hw = thread::hardware_concurrency();
+        num_dp = max(1, hw - 1 - filter_threads - fold_threads);
+    }
+
+    BoundedQueue<PackedLoop> loops(loop_capacity, 1);
+    BoundedQueue<string> loopstrs(loopstr_capacity, filter_threads);
+    BoundedQueue<array<int, 32>> folds(fold_capacity, fold_threads);
+
+    auto cancel_all = [&]() {
+        loops.cancel();
+        loopstrs.cancel();
+        folds.cancel();
+    };
+
+    Result result;
+    mutex result_mutex;
+    atomic<unsigned long long> num_loops(0), num_loopstrs(0), num_folds(0),
+        num_checked(0);
+    atomic<long long> first_fold_ms(-1);
+
+    // 内側5x5の判定表はDPのスレッドごとに持つ
+    // 先に読み込んでおく（無ければ最初の1つで作って保存する）
+    string oracle_path = GetOraclePath();
+    vector<unique_ptr<InteriorOracle>> oracles;
+    for (int t = 0; t < num_dp; t++) {
+        oracles.emplace_back(new InteriorOracle());
+        oracles.back()->load_or_build(oracle_path);
+    }
+
+    vector<thread> threads;
+
+    // 1. ループの列挙
+    threads.emplace_back([&]() {
+        bg.streamFeasibleClockwiseLoops([&](const PackedLoop &loop) {
+            num_loops++;
+            return loops.push(loop);
+        });
+        loops.close();
+    });
+
+    // 2. 距離条件を満たすズラシのうち、カドと斜め線の条件を満たすもの
+    for (int t = 0; t < filter_threads; t++) {
+        threads.emplace_back([&]() {
+            PackedLoop loop;
+            while (loops.pop(loop)) {
+                unsigned int slides = feasible_slides(loop);
+                for (int j = 0; j < 8; j++) {
+                    if (((slides >> j) & 1) == 0)
+                        continue;
+                    string loopstr = loop.rotated(j).turn_string();
+                    if (is_NG_loopstr(loopstr))
+                        continue;
+                    num_loopstrs++;
+                    if (!loopstrs.push(loopstr))
+                        break;
+                }
+            }
+            loopstrs.close();
+        });
+    }
+
+    // 3. 折り割り当ての生成
+    for (int t = 0; t < fold_threads; t++) {
+        threads.emplace_back([&]() {
+            string loopstr;
+            while (loopstrs.pop(loopstr)) {
+                for (const auto &f : createAllFolds(loopstr)) {
+                    array<int, 32> fold;
+                    copy_n(f.begin(), 32, fold.begin());
+                    num_folds++;
+                    if (!folds.push(fold))
+                        break;
+                }
+            }
+            folds.close();
+        });
+    }
+
+    // 4. DP
+    // 局所的な矛盾がある折り割り当てと、以前に失敗した部分割り当てを含む
+    // 折り割り当てはDPにかけない（findCP_old と同じ。nogood はスレッドごと）
+    for (int t = 0; t < num_dp; t++) {
+        threads.emplace_back([&, t]() {
+            Counter c(7);
+            FoldPrefilter prefilter;
+            FoldNogood nogood;
+            InteriorOracle &oracle = *oracles[t];
+
+            array<int, 32> fold;
+            while (folds.pop(fold)) {
+                long long none = -1;
+                first_fold_ms.compare_exchange_strong(none, elapsed_ms());
+
+                if (!prefilter.check(fold))
+                    continue;
+                if (nogood.contains(fold))
+                    continue;
+                num_checked++;
+
+                array<uint64_t, 49> domain = create_tile_domain_by_folds(fold);
+                if (!oracle.has_cp(domain)) {
+                    nogood.learn(c, fold, oracle.get_dead_cell());
+                    continue;
+                }
+
+                string cpstr = c.domain_to_cpstr(domain);
+                lock_guard<mutex> lock(result_mutex);
+                if (!result.found) {
+                    result.found = true;
+                    result.cpstr = cpstr;
+                    result.folds = fold;
+                    result.found_ms = elapsed_ms();
+                }
+                cancel_all();
+                break;
+            }
+        });
+    }
+
+    for (auto &th : threads)
+        th.join();
+
+    result.first_fold_ms = first_fold_ms;
+    result.loops = num_loops;
+    result.loopstrs = num_loopstrs;
+    result.folds_generated = num_folds;
+    result.dp_checked = num_checked;
+    return result;
+}
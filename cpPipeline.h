@@ -0,0 +1,46 @@
+#pragma once
+
+#include "BoundaryGraph.h"
+
+#include <array>
+#include <string>
+
+// findCP_old の各段
+//   ループの列挙 → ズラシと条件での絞り込み → 折り割り当ての生成 → DP
+// をそれぞれ別のスレッドで動かし、段の間を BoundedQueue でつなぐ
+//
+// DP は最初の折り割り当てができた時点で始まり、ループの列挙と並行して進む
+// 後段が詰まると前段はキューへの追加で待つので、途中の結果がたまりすぎない
+// CP が見つかるとすべてのキューを cancel し、前段の探索も止める
+// 最初に見つかる CP を早く返すためのもので、どの CP が見つかるかは
+// スレッドの進み方で変わる
+class CPPipeline {
+  public:
+    // 各段のスレッド数（dp_threads が 0 なら空いているコア数から決める）
+    int filter_threads = 1;
+    int fold_threads = 1;
+    int dp_threads = 0;
+
+    // 段の間のキューの長さ
+    int loop_capacity = 64;
+    int loopstr_capacity = 256;
+    int fold_capacity = 4096;
+
+    struct Result {
+        bool found = false;
+        std::string cpstr;
+        std::array<int, 32> folds;
+
+        // 開始から、最初の折り割り当てがDPに届くまでと、CPが見つかるまで (ms)
+        long long first_fold_ms = -1;
+        long long found_ms = -1;
+
+        // 各段が次の段に渡した数と、DPにかけた数
+        unsigned long long loops = 0;
+        unsigned long long loopstrs = 0;
+        unsigned long long folds_generated = 0;
+        unsigned long long dp_checked = 0;
+    };
+
+    Result run(BoundaryGraph &bg);
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// 距離条件（折った後の2点の距離が展開図上の距離を超えない）を判定するための表
+// ループを作りながら1頂点ずつ判定する update_slides と、
+// できあがったループ全体を判定する feasible_slides がある
+// ループの位置 p の頂点は、ズラシ j のとき外周頂点 (p - j) mod 32 に割り当てられる
+// 外周を8だけ回すと正方形の回転になり距離は変わらないので、ズラシは 0..7 の8通り
+// 条件を満たしうるズラシの集合を8bitのマスクで持つ
+// 表はすべてコンパイル時に計算する
+//
+// 表は2点の組ごとに8通りのズラシの値を16bit x 8 に並べてあり、
+// 1回のベクトル比較で8通りのズラシをまとめて判定する
+
+// 外周頂点 i の展開図上の座標
+constexpr int OUTER_COORD_X[32] = {
+    0, 1, 2, 3, 4, 5, 6, 7, //
+    8, 8, 8, 8, 8, 8, 8, 8, //
+    8, 7, 6, 5, 4, 3, 2, 1, //
+    0, 0, 0, 0, 0, 0, 0, 0  //
+};
+constexpr int OUTER_COORD_Y[32] = {
+    0, 0, 0, 0, 0, 0, 0, 0, //
+    0, 1, 2, 3, 4, 5, 6, 7, //
+    8, 8, 8, 8, 8, 8, 8, 8, //
+    8, 7, 6, 5, 4, 3, 2, 1  //
+};
+
+constexpr unsigned int ALL_SLIDES = 0xff;
+
+// 8通りのズラシを並べた16bit x 8 のベクトル（GCC のベクトル拡張）
+typedef std::int16_t SlideLanes __attribute__((vector_size(16)));
+
+// SLIDE_LIMIT.d2[p][q][j] : ズラシ j のとき、ループの位置 p と q の頂点の
+//                           展開図上の距離の2乗
+struct SlideLimit {
+    alignas(16) std::int16_t d2[32][32][8];
+};
+
+constexpr SlideLimit make_slide_limit() {
+    SlideLimit t{};
+    for (int p = 0; p < 32; p++) {
+        for (int q = 0; q < 32; q++) {
+            for (int j = 0; j < 8; j++) {
+                int a = (p - j + 32) % 32;
+                int b = (q - j + 32) % 32;
+                int dx = OUTER_COORD_X[a] - OUTER_COORD_X[b];
+                int dy = OUTER_COORD_Y[a] - OUTER_COORD_Y[b];
+                t.d2[p][q][j] = dx * dx + dy * dy;
+            }
+        }
+    }
+    return t;
+}
+
+constexpr SlideLimit SLIDE_LIMIT = make_slide_limit();
+
+// 位置 p と q の頂点の距離の2乗が d2 のとき、条件を破るズラシのレーンを -1 にする
+inline SlideLanes slide_violations(int p, int q, int d2) {
+    SlideLanes limit;
+    std::memcpy(&limit, SLIDE_LIMIT.d2[p][q], sizeof(limit));
+    SlideLanes folded = {(std::int16_t)d2, (std::int16_t)d2, (std::int16_t)d2,
+                         (std::int16_t)d2, (std::int16_t)d2, (std::int16_t)d2,
+                         (std::int16_t)d2, (std::int16_t)d2};
+    return (SlideLanes)(folded > limit);
+}
+
+// 条件を破ったレーンを slides から除く
+inline unsigned int remove_violations(unsigned int slides, SlideLanes bad) {
+    for (int j = 0; j < 8; j++)
+        if (bad[j] != 0)
+            slides &= ~(1u << j);
+    return slides;
+}
+
+inline bool all_lanes_set(SlideLanes bad) {
+    std::uint64_t w[2];
+    std::memcpy(w, &bad, sizeof(w));
+    return (w[0] & w[1]) == ~0ULL;
+}
+
+// ループの位置 pos に頂点 (xs[pos], ys[pos]) を置いたとき、位置 0..pos-1 の
+// 頂点との距離を調べ、slides のうち条件を満たし続けるズラシの集合を返す
+inline unsigned int update_slides(unsigned int slides, int pos, const int *xs,
+                                  const int *ys) {
+    if (slides == 0)
+        return 0;
+    SlideLanes bad = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int q = 0; q < pos; q++) {
+        int dx = xs[pos] - xs[q];
+        int dy = ys[pos] - ys[q];
+        bad |= slide_violations(q, pos, dx * dx + dy * dy);
+    }
+    return remove_violations(slides, bad);
+}
+
+// 32頂点のループ全体（座標は xs, ys の SoA）について、
+// 距離条件を満たすズラシの集合を返す
+inline unsigned int feasible_slides(const int *xs, const int *ys) {
+    SlideLanes bad = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int p = 0; p < 32; p++) {
+        for (int q = p + 1; q < 32; q++) {
+            int dx = xs[p] - xs[q];
+            int dy = ys[p] - ys[q];
+            bad |= slide_violations(p, q, dx * dx + dy * dy);
+        }
+        // 8通りすべてが破れたら打ち切る
+        if (all_lanes_set(bad))
+            return 0;
+    }
+    return remove_violations(ALL_SLIDES, bad);
+}
@@ -0,0 +1,170 @@
+#include "dotPrefilter.h"
+
+#include "loopKernels.h"
+#include "packedLoop.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// 頂点 (x, y) は y * 9 + x の番号（PackedLoop と同じ）
+struct DotBoundary {
+    int cell[10][10] = {}; // 周りに白いマスを1列足したドット絵（[y + 1][x + 1]）
+    int num_edges = 0;
+    int degree[81] = {};
+    int next[81][4];
+
+    explicit DotBoundary(const vector<vector<int>> &grid) {
+        for (int y = 0; y < 8; y++)
+            for (int x = 0; x < 8; x++)
+                cell[y + 1][x + 1] = grid[y][x] != 0;
+
+        for (int y = 0; y <= 8; y++) {
+            for (int x = 0; x <= 8; x++) {
+                // 横の辺 (x, y)-(x+1, y) は上下のマス、縦の辺 (x, y)-(x, y+1) は
+                // 左右のマスの色が異なるときに境界になる
+                if (x < 8 && cell[y][x + 1] != cell[y + 1][x + 1])
+                    add(y * 9 + x, y * 9 + x + 1);
+                if (y < 8 && cell[y + 1][x] != cell[y + 1][x + 1])
+                    add(y * 9 + x, (y + 1) * 9 + x);
+            }
+        }
+    }
+
+    void add(int u, int v) {
+        next[u][degree[u]++] = v;
+        next[v][degree[v]++] = u;
+        num_edges++;
+    }
+
+    bool connected() const {
+        int first = -1;
+        for (int v = 0; v < 81 && first < 0; v++)
+            if (degree[v] > 0)
+                first = v;
+        if (first < 0)
+            return true;
+        bool seen[81] = {};
+        int stack[81], top = 0, count = 0;
+        stack[top++] = first;
+        seen[first] = true;
+        while (top > 0) {
+            int u = stack[--top];
+            count++;
+            for (int i = 0; i < degree[u]; i++) {
+                int v = next[u][i];
+                if (!seen[v]) {
+                    seen[v] = true;
+                    stack[top++] = v;
+                }
+            }
+        }
+        for (int v = 0; v < 81; v++)
+            if (degree[v] > 0)
+                count--;
+        return count == 0;
+    }
+
+    // 頂点 u から見た隣の頂点 v の向き（0 : 上、1 : 右、2 : 下、3 : 左）
+    static int direction(int u, int v) {
+        if (v == u - 9)
+            return 0;
+        if (v == u + 1)
+            return 1;
+        if (v == u + 9)
+            return 2;
+        return 3;
+    }
+
+    // 十字路ごとの曲がり方を bit で決めたときのループ（時計回り）
+    // bit が 0 なら上と右・下と左、1 なら上と左・下と右の辺を続けて通る
+    // 1本のループにならなければ false
+    bool trace_loop(const int *crossroad_index, unsigned int pattern,
+                    PackedLoop &loop) const {
+        int start = 0;
+        while (degree[start] != 2)
+            start++;
+        int nodes[PackedLoop::LENGTH];
+        int n = 0;
+        int prev = start, u = next[start][0];
+        nodes[n++] = start;
+        while (u != start) {
+            if (n == PackedLoop::LENGTH)
+                return false;
+            nodes[n++] = u;
+            int v;
+            if (degree[u] == 2) {
+                v = next[u][0] == prev ? next[u][1] : next[u][0];
+            } else {
+                int in = direction(u, prev);
+                bool bit = (pattern >> crossroad_index[u]) & 1;
+                int out = bit ? 3 - in : in ^ 1;
+                const int step[4] = {-9, 1, 9, -1};
+                v = u + step[out];
+            }
+            prev = u;
+            u = v;
+        }
+        if (n != PackedLoop::LENGTH)
+            return false;
+
+        vector<int> path(nodes, nodes + n);
+        PackedLoop::pack(path, loop);
+        if (loop.right_turns() < loop.left_turns()) {
+            reverse(path.begin(), path.end());
+            PackedLoop::pack(path, loop);
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+DotReject check_dot_art(const vector<vector<int>> &grid, int loop_length) {
+    if (loop_length != PackedLoop::LENGTH)
+        return DotReject::LOOP_LENGTH;
+
+    DotBoundary b(grid);
+    if (b.num_edges != loop_length || !b.connected())
+        return DotReject::DISCONNECTED;
+
+    int crossroads = 0;
+    int crossroad_index[81];
+    for (int v = 0; v < 81; v++) {
+        if (b.degree[v] % 2 != 0)
+            return DotReject::DEGREE_PARITY;
+        if (b.degree[v] == 4)
+            crossroad_index[v] = crossroads++;
+    }
+
+    bool has_loop = false;
+    for (unsigned int pattern = 0; pattern < (1u << crossroads); pattern++) {
+        PackedLoop loop;
+        if (!b.trace_loop(crossroad_index, pattern, loop))
+            continue;
+        has_loop = true;
+        if (feasible_slides(loop) != 0)
+            return DotReject::NONE;
+    }
+    return has_loop ? DotReject::DISTANCE : DotReject::CROSSROADS;
+}
+
+const char *dot_reject_name(DotReject r) {
+    switch (r) {
+    case DotReject::NONE:
+        return "none";
+    case DotReject::LOOP_LENGTH:
+        return "loop length";
+    case DotReject::DISCONNECTED:
+        return "disconnected boundary";
+    case DotReject::DEGREE_PARITY:
+        return "degree parity";
+    case DotReject::CROSSROADS:
+        return "crossroad count";
+    case DotReject::DISTANCE:
+        return "distance";
+    }
+    return "";
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+// ループを列挙する前に、ドット絵だけから外周のループが作れないものを棄却する
+// 安い順に次の必要条件を調べ、最初に破れたものを返す
+//   1. ループ長が32
+//   2. 境界がつながっている（橋を足すものは solve_non_connect で扱う）
+//   3. 境界の頂点の次数がすべて偶数
+//   4. 十字路で曲がってできる1本のループがある
+//      次数2の頂点での進み方は決まっているので、ループは十字路 c 個での
+//      曲がり方（2通りずつ）で決まる。2^c 通りをそれぞれ32歩でたどる
+//   5. そのループのどれかに、距離条件を満たすズラシがある
+// 32辺のドット絵の十字路は多くても16個で、ふつうは数個なので 4 と 5 も安い
+enum class DotReject {
+    NONE,
+    LOOP_LENGTH,
+    DISCONNECTED,
+    DEGREE_PARITY,
+    CROSSROADS,
+    DISTANCE,
+};
+
+// grid は 8x8 のドット絵、loop_length は calcLoopLength の値
+DotReject check_dot_art(const std::vector<std::vector<int>> &grid,
+                        int loop_length);
+
+// 棄却した条件の名前
+const char *dot_reject_name(DotReject r);
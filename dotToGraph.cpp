@@ -1,13 +1,24 @@
 // ドット絵からループを出力
 
 #include "BoundaryGraph.h"
+#include "cpPipeline.h"
+#include "dotPrefilter.h"
+#include "foldNogood.h"
+#include "foldPrefilter.h"
 #include "foldsToEdges.h"
 #include "ftcp.h"
+#include "interiorOracle.h"
+#include "loopKernels.h"
+#include "loopSolver.h"
 #include "loopToFolds.h"
+#include "packedLoop.h"
+#include "resultCache.h"
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <climits>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -18,15 +29,6 @@
 
 using namespace std;
 
-// 文字列の先頭n文字を末尾に移動させる関数
-static string rotateString(string s, int n)
-{
-    if (s.empty())
-        return s;
-    n %= s.length();
-    return s.substr(n) + s.substr(0, n);
-}
-
 // vector<int>の先頭32要素をarray<int, 32>に変換する関数
 static array<int, 32> vectorToArray(const vector<int> &v)
 {
@@ -35,34 +37,6 @@ static array<int, 32> vectorToArray(const vector<int> &v)
     return arr;
 }
 
-bool is_NG_loopstr(string loopstr)
-{
-    // カドの配置について
-    if (loopstr[0] == 'S')
-        return true;
-    if (loopstr[8] == 'S')
-        return true;
-    if (loopstr[16] == 'S')
-        return true;
-    if (loopstr[24] == 'S')
-        return true;
-
-    // 偶頂点から出る斜め線の本数は偶数でなければならない
-    // 奇頂点から出る斜め線の本数は偶数でなければならない
-    int count[2] = {0, 0};
-    for (int i = 0; i < 32; i++)
-    {
-        if (i % 8 == 0)
-            continue;
-        char c = loopstr[i];
-        if (c != 'S')
-            count[i % 2]++;
-    }
-    if (count[0] % 2 != 0 || count[1] % 2 != 0)
-        return true;
-    return false;
-}
-
 vector<vector<int>> dotstrTo2DVector(string dotstr)
 {
     vector<vector<int>> dotArt;
@@ -90,118 +64,22 @@ vector<vector<int>> dotstrTo2DVector(string dotstr)
     return dotArt;
 }
 
-int distance(int x1, int y1, int x2, int y2)
-{
-    return (x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2);
-}
-
-int OUTER_X[32] = {
-    0, 1, 2, 3, 4, 5, 6, 7, //
-    8, 8, 8, 8, 8, 8, 8, 8, //
-    8, 7, 6, 5, 4, 3, 2, 1, //
-    0, 0, 0, 0, 0, 0, 0, 0  //
-};
-
-int OUTER_Y[32] = {
-    0, 0, 0, 0, 0, 0, 0, 0, //
-    0, 1, 2, 3, 4, 5, 6, 7, //
-    8, 8, 8, 8, 8, 8, 8, 8, //
-    8, 7, 6, 5, 4, 3, 2, 1  //
-};
-
-// 距離条件によるスライド可能性の判定
-// サーキット上の点の先頭からstep個目が第一コーナーに割り当てられる
-bool can_slide(const vector<Point> &circuit, int step)
-{
-    return true;
-    for (int i = 0; i < 32; i++)
-    {
-        for (int j = i + 1; j < 32; j++)
-        {
-
-            // 展開図上でのiとjの距離の計算
-            int q1 = (i - step + 32) % 32;
-            int q2 = (j - step + 32) % 32;
-            int x1 = OUTER_X[q1];
-            int y1 = OUTER_Y[q1];
-            int x2 = OUTER_X[q2];
-            int y2 = OUTER_Y[q2];
-            int dist1 = distance(x1, y1, x2, y2);
-
-            // サーキット上でのiとjの距離の計算
-            int p1 = i;
-            int p2 = j;
-            int x3 = circuit[p1].x;
-            int y3 = circuit[p1].y;
-            int x4 = circuit[p2].x;
-            int y4 = circuit[p2].y;
-            int dist2 = distance(x3, y3, x4, y4);
-
-            // 展開図上での距離とサーキット上での距離の比較
-            if (dist1 < dist2)
-            {
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-// 距離条件判定
-// サーキット上の先頭の頂点がカドに割り当てられる
-bool distance_condition(const vector<Point> &circuit)
-{
-
-    for (int i = 0; i < 32; i++)
-    {
-        for (int j = i + 1; j < 32; j++)
-        {
-
-            // 展開図上でのiとjの距離の計算
-            int x1 = OUTER_X[i];
-            int y1 = OUTER_Y[i];
-            int x2 = OUTER_X[j];
-            int y2 = OUTER_Y[j];
-            int distOnCP = distance(x1, y1, x2, y2);
-
-            // サーキット上でのiとjの距離の計算
-            int x3 = circuit[i].x;
-            int y3 = circuit[i].y;
-            int x4 = circuit[j].x;
-            int y4 = circuit[j].y;
-            int distOnCircuit = distance(x3, y3, x4, y4);
-
-            // 展開図上での距離とサーキット上での距離の比較
-            if (distOnCP < distOnCircuit)
-            {
-                // 不適である根拠を表示
-                // cout << "i :" << i << " j :" << j << endl;
-                // cout << "distOnCP :" << distOnCP
-                //  << " distOnCircuit :" << distOnCircuit << endl;
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-void print_circuit(const vector<Point> &circuit)
+void print_circuit(const PackedLoop &circuit)
 {
     cout << "print_circuit" << endl;
     for (int i = 0; i < 32; i++)
     {
-        Point p = circuit[i];
-        cout << i << " (" << p.x << "," << p.y << ")" << endl;
+        cout << i << " (" << circuit.x(i) << "," << circuit.y(i) << ")"
+             << endl;
     }
 }
 
-void print_circuit2(const vector<Point> &circuit)
+void print_circuit2(const PackedLoop &circuit)
 {
     cout << "print_circuit" << endl;
     for (int i = 0; i < 32; i++)
     {
-        Point p = circuit[i];
-        cout << p.x + p.y * 9 << " ";
+        cout << circuit.node(i) << " ";
     }
     cout << endl;
 }
@@ -220,48 +98,31 @@ void findCP(string dotstr, int skip)
     bg.build(dotArt);
 
     // ドット絵からループを作成
-    vector<vector<Point>> cycles = bg.findClockwiseCycles();
+    vector<PackedLoop> cycles = bg.findFeasibleClockwiseLoops();
     cout << cycles.size() << " Cycles found" << endl;
 
-    // ループから8通りのズラシを生成
-    vector<vector<Point>> rotateLoops;
-    for (auto c : cycles)
+    // ループから8通りのズラシを生成し、距離条件を満たすものを抽出
+    // 8通りのズラシの距離条件は feasible_slides でまとめて判定する
+    vector<PackedLoop> loops;
+    for (const auto &c : cycles)
     {
+        unsigned int slides = feasible_slides(c);
         for (int i = 0; i < 8; i++)
         {
-            vector<Point> tmp = c;
-            tmp.pop_back(); // なぜかサイズが33なので一度32にしておく
-            std::rotate(tmp.begin(), tmp.begin() + i, tmp.end());
-            tmp.push_back(tmp[0]);
-            rotateLoops.push_back(tmp);
-        }
-    }
-    cout << rotateLoops.size() << " loops generated by slide" << endl;
-
-    // ループのうち、距離条件を満たすものを抽出
-    vector<vector<Point>> loops;
-    for (auto c : rotateLoops)
-    {
-        if (distance_condition(c))
-        {
-            loops.push_back(c);
+            if ((slides >> i) & 1)
+            {
+                loops.push_back(c.rotated(i));
+            }
         }
     }
+    cout << cycles.size() * 8 << " loops generated by slide" << endl;
     cout << loops.size() << " loops generated by distance condition" << endl;
 
-    // ループを方向表示に変換
-    vector<vector<string>> loops_dir;
-    for (auto c : loops)
-    {
-        vector<string> dir = bg.getPathDirections(c);
-        loops_dir.push_back(dir);
-    }
-
     // ループのうちカド条件と偶奇頂点の斜め線の条件を満たすものを抽出
     vector<string> loops2;
-    for (auto c : loops_dir)
+    for (const auto &c : loops)
     {
-        string loop = bg.directionsToString(c);
+        string loop = c.turn_string();
 
         if (is_NG_loopstr(loop))
             continue;
@@ -288,17 +149,31 @@ void findCP(string dotstr, int skip)
     }
 
     // 平坦折り可能な折り割り当てを探す
+    // 局所的な矛盾がある折り割り当てと、以前に失敗した部分割り当てを含む
+    // 折り割り当てはDPにかけない
+    // 内側5x5の判定は事前計算した表で行う
+    FoldPrefilter prefilter;
+    FoldNogood nogood;
+    InteriorOracle oracle;
+    oracle.load_or_build(GetOraclePath());
     int flatFoldsID = -1;
     for (int i = 0; i < folds_arr.size(); i++)
     {
-        vector<int> edges = create_edges_by_folds(folds_arr[i]);
-        string cpstr = cpFinder.edges_to_cpstr(edges);
-        if (cpstr != "No CP")
+        if (!prefilter.check(folds_arr[i]))
+            continue;
+        if (nogood.contains(folds_arr[i]))
+            continue;
+
+        array<uint64_t, 49> domain = create_tile_domain_by_folds(folds_arr[i]);
+        if (oracle.has_cp(domain))
         {
             flatFoldsID = i;
             break;
         }
+        nogood.learn(cpFinder, folds_arr[i], oracle.get_dead_cell());
     }
+    prefilter.print_stats("");
+    nogood.print_stats("");
 
     // 平坦折り可能な折り割り当てが無ければ終了
     if (flatFoldsID == -1)
@@ -308,8 +183,9 @@ void findCP(string dotstr, int skip)
     }
 
     // 平坦折り可能な折り割り当てがあればCPを得る
-    vector<int> edges = create_edges_by_folds(folds_arr[flatFoldsID]);
-    string cpstr = cpFinder.edges_to_cpstr(edges);
+    array<uint64_t, 49> domain =
+        create_tile_domain_by_folds(folds_arr[flatFoldsID]);
+    string cpstr = cpFinder.domain_to_cpstr(domain);
     cout << cpstr << endl;
 
     // CPの4隅を復元
@@ -344,7 +220,7 @@ void findCP_old(string dotstr, int skip)
 
     // ドット絵からループを作成
     start = std::chrono::high_resolution_clock::now();
-    vector<vector<Point>> cycles = bg.findClockwiseCycles();
+    vector<PackedLoop> cycles = bg.findFeasibleClockwiseLoops();
     end = std::chrono::high_resolution_clock::now();
 
     cout << cycles.size() << " Cycles found" << endl;
@@ -354,24 +230,19 @@ void findCP_old(string dotstr, int skip)
          << "ms" << endl;
 
     Counter c(7);
+    FoldPrefilter prefilter;
+    FoldNogood nogood;
+    InteriorOracle oracle;
+    oracle.load_or_build(GetOraclePath());
 
     for (int i = 0; i < cycles.size(); i++)
     {
         // サイクルを方向表示に変換
-        vector<string> directions = bg.getPathDirections(cycles[i]);
-        string dirstr = bg.directionsToString(directions);
+        string dirstr = cycles[i].turn_string();
         cout << "cycle " << i << ": " << dirstr << endl;
 
         // 距離条件を8個のズラシに対して調査
-        bool distanceCondition[8];
-        for (int j = 0; j < 8; j++)
-        {
-            vector<Point> tmp = cycles[i];
-            tmp.pop_back(); // なぜかサイズが33なので一度32
-            std::rotate(tmp.begin(), tmp.begin() + j, tmp.end());
-            tmp.push_back(tmp[0]);
-            distanceCondition[j] = distance_condition(tmp);
-        }
+        unsigned int slides = feasible_slides(cycles[i]);
 
         // サイクル（方向）から折割当を生成
         auto fold_start = std::chrono::high_resolution_clock::now();
@@ -382,10 +253,10 @@ void findCP_old(string dotstr, int skip)
         {
 
             // 距離条件を満たさないものはスキップ
-            if (distanceCondition[j] == false)
+            if (((slides >> j) & 1) == 0)
                 continue;
 
-            rotatestr = rotateString(dirstr, j);
+            rotatestr = cycles[i].rotated(j).turn_string();
             // この時点でNGな開始点を除去
             if (is_NG_loopstr(rotatestr))
                 continue;
@@ -423,10 +294,22 @@ void findCP_old(string dotstr, int skip)
             vector<int> fold = folds[k];
             array<int, 32> foldArr = vectorToArray(fold);
 
+            // 局所的な矛盾がある折り割り当てはDPにかけない
+            if (!prefilter.check(foldArr))
+                continue;
+
+            // 以前に失敗した部分割り当てを含むものもDPにかけない
+            if (nogood.contains(foldArr))
+                continue;
+
             auto f2c_start = std::chrono::high_resolution_clock::now();
 
-            vector<int> edges = create_edges_by_folds(foldArr);
-            string cpstr = c.edges_to_cpstr(edges);
+            array<uint64_t, 49> domain = create_tile_domain_by_folds(foldArr);
+            string cpstr = "No CP";
+            if (oracle.has_cp(domain))
+                cpstr = c.domain_to_cpstr(domain);
+            else
+                nogood.learn(c, foldArr, oracle.get_dead_cell());
 
             auto f2c_end = std::chrono::high_resolution_clock::now();
             total_folds_to_cpstr_time +=
@@ -460,6 +343,8 @@ void findCP_old(string dotstr, int skip)
                      << "ms" << endl;
                 cout << "  Total folds_to_cpstr: " << total_folds_to_cpstr_time
                      << "ms" << endl;
+                prefilter.print_stats("  ");
+                nogood.print_stats("  ");
 
                 auto total_end = std::chrono::high_resolution_clock::now();
                 cout << "Total Time: "
@@ -478,6 +363,8 @@ void findCP_old(string dotstr, int skip)
              << "ms" << endl;
         cout << "  Total folds_to_cpstr: " << total_folds_to_cpstr_time << "ms"
              << endl;
+        prefilter.print_stats("  ");
+        nogood.print_stats("  ");
     }
 
     cout << "No CP" << endl;
@@ -489,6 +376,211 @@ void findCP_old(string dotstr, int skip)
          << "ms" << endl;
 }
 
+// 展開図と4隅を出力する（Model.py が CPSTR と CORNERS の行を読む）
+static void printCP(const string &cpstr, const array<int, 4> &corners)
+{
+    cout << cpstr << endl;
+
+    string cornersstr = "";
+    for (int k = 0; k < 4; k++)
+        cornersstr += " " + to_string(corners[k]);
+
+    // CPの描画
+    cout << "CPSTR:" << cpstr << endl;
+    cout << "CORNERS:" << cornersstr << endl;
+}
+
+// ループ cycle をずらし slide で LoopSolver に解かせ、解ければ展開図を solution に入れる
+static bool solveSlide(LoopSolver &solver, const PackedLoop &cycle, int slide,
+                       ResultCache::Solution &solution)
+{
+    // この時点でNGな開始点を除去
+    string rotatestr = cycle.rotated(slide).turn_string();
+    if (is_NG_loopstr(rotatestr) || !solver.solve(rotatestr))
+        return false;
+
+    solution.slide = slide;
+    solution.loop = cycle;
+    solution.folds = solver.get_folds();
+    solution.cpstr = solver.get_cpstr();
+
+    // 4隅の復元
+    for (int k = 0; k < 4; k++)
+    {
+        int outer = k * 8 + 1;
+        solution.corners[k] = get_edge_from_fold(solution.folds[outer], 2);
+    }
+    return true;
+}
+
+// 折り割り当てを列挙せず、ループごとに LoopSolver で平坦折り可能か判定する
+// 結果は回転・反転をまとめて cache に残し、途中で止めても続きから探す
+// cache から読んだループや展開図は、このドット絵の向きに移してある
+void findCP_by_loop(string dotstr, ResultCache &cache)
+{
+    auto start_total = std::chrono::high_resolution_clock::now();
+
+    vector<vector<int>> dotArt = dotstrTo2DVector(dotstr);
+    int frame;
+    uint64_t key = ResultCache::canonical_key(dotArt, frame);
+    ResultCache::Slot *slot = cache.find(key);
+    LoopSolver solver;
+    if (slot != nullptr && slot->state == ResultCache::NO_CP)
+    {
+        cout << "Cached result" << endl;
+        cout << "No CP" << endl;
+        auto total_end = std::chrono::high_resolution_clock::now();
+        cout << "Total Time: "
+             << std::chrono::duration_cast<std::chrono::microseconds>(
+                    total_end - start_total)
+                    .count()
+             << "us" << endl;
+        return;
+    }
+    if (slot != nullptr && slot->state == ResultCache::FOUND)
+    {
+        // 反転を含む向きの違いで展開図が無ければ、そのループとずらしだけを解き直す
+        ResultCache::Solution s;
+        bool cached = ResultCache::load_cp(*slot, frame, s);
+        if (cached || solveSlide(solver, s.loop, s.slide, s))
+        {
+            cout << (cached ? "Cached result" : "Cached loop") << endl;
+            if (!cached)
+                ResultCache::store_cp(*slot, s, frame);
+            cout << "CP found with cycle " << s.cycle << endl;
+            printCP(s.cpstr, s.corners);
+            auto total_end = std::chrono::high_resolution_clock::now();
+            cout << "Total Time: "
+                 << std::chrono::duration_cast<std::chrono::microseconds>(
+                        total_end - start_total)
+                        .count()
+                 << "us" << endl;
+            return;
+        }
+    }
+    if (slot == nullptr)
+        slot = cache.insert(key);
+
+    // ドット絵からループを作成（前に途中まで探していれば、そのときのループ）
+    vector<PackedLoop> cycles;
+    if (slot != nullptr && slot->num_cycles != ResultCache::CYCLES_NOT_STORED)
+    {
+        cycles = ResultCache::load_cycles(*slot, frame);
+        cout << cycles.size() << " Cycles found (resumed)" << endl;
+    }
+    else
+    {
+        BoundaryGraph bg;
+        bg.build(dotArt);
+        cycles = bg.findFeasibleClockwiseLoops();
+        cout << cycles.size() << " Cycles found" << endl;
+        if (slot != nullptr)
+            ResultCache::store_cycles(*slot, cycles, frame);
+    }
+    bool track = slot != nullptr &&
+                 slot->num_cycles != ResultCache::CYCLES_NOT_STORED;
+
+    for (int i = 0; i < cycles.size(); i++)
+    {
+        // サイクルを方向表示に変換
+        string dirstr = cycles[i].turn_string();
+        cout << "cycle " << i << ": " << dirstr << endl;
+
+        auto solve_start = std::chrono::high_resolution_clock::now();
+        unsigned int slides = feasible_slides(cycles[i]);
+        if (track)
+            slides &= ~ResultCache::infeasible_slides(*slot, i, cycles[i],
+                                                      frame);
+        for (int j = 0; j < 8; j++)
+        {
+            // 距離条件を満たさないもの、前に解けなかったものはスキップ
+            if (((slides >> j) & 1) == 0)
+                continue;
+            ResultCache::Solution s;
+            if (!solveSlide(solver, cycles[i], j, s))
+            {
+                if (track)
+                    ResultCache::mark_infeasible(*slot, i, cycles[i], j,
+                                                 frame);
+                continue;
+            }
+            s.cycle = i;
+
+            cout << "CP found with cycle " << i << endl;
+            printCP(s.cpstr, s.corners);
+            if (slot != nullptr)
+                ResultCache::store_cp(*slot, s, frame);
+
+            auto total_end = std::chrono::high_resolution_clock::now();
+            cout << "Total Time: "
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(
+                        total_end - start_total)
+                        .count()
+                 << "ms" << endl;
+            return;
+        }
+
+        auto solve_end = std::chrono::high_resolution_clock::now();
+        cout << "  Solve Loop: "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(
+                    solve_end - solve_start)
+                    .count()
+             << "ms" << endl;
+    }
+
+    cout << "No CP" << endl;
+    if (slot != nullptr)
+        slot->state = ResultCache::NO_CP;
+    auto total_end = std::chrono::high_resolution_clock::now();
+    cout << "Total Time: "
+         << std::chrono::duration_cast<std::chrono::milliseconds>(total_end -
+                                                                  start_total)
+                .count()
+         << "ms" << endl;
+}
+
+// findCP_old の各段を別々のスレッドで並行に動かしてCPを探す
+// どのCPが見つかるかは実行ごとに変わりうる
+void findCP_pipeline(string dotstr)
+{
+    // ドット絵をグラフ化
+    vector<vector<int>> dotArt = dotstrTo2DVector(dotstr);
+    BoundaryGraph bg;
+    bg.build(dotArt);
+
+    CPPipeline pipeline;
+    CPPipeline::Result result = pipeline.run(bg);
+
+    cout << result.loops << " Cycles found" << endl;
+    cout << result.loopstrs << " loops generated by distance, corner and edge "
+         << "condition" << endl;
+    cout << "  Num Folds: " << result.folds_generated << endl;
+    cout << "  Checked by DP: " << result.dp_checked << endl;
+    cout << "First Fold Time: " << result.first_fold_ms << "ms" << endl;
+
+    if (!result.found)
+    {
+        cout << "No CP" << endl;
+        return;
+    }
+
+    cout << "CP Found Time: " << result.found_ms << "ms" << endl;
+    cout << result.cpstr << endl;
+
+    // 4隅の復元
+    string cornersstr = "";
+    for (int i = 0; i < 4; i++)
+    {
+        int outer = i * 8 + 1;
+        int e = get_edge_from_fold(result.folds[outer], 2);
+        cornersstr += " " + to_string(e);
+    }
+
+    // CPの描画
+    cout << "CPSTR:" << result.cpstr << endl;
+    cout << "CORNERS:" << cornersstr << endl;
+}
+
 string Vector2DToString(const vector<vector<int>> &v)
 {
     string exampleStr = "";
@@ -563,67 +655,141 @@ set<Edge> calcConvexHullEdgeSet(const set<Edge> &B)
     return H;
 }
 
-int calcLoopLength(string dotstr)
+// 境界辺集合 B の連結成分をすべてつなぐのに足りない辺の最小本数
+// 凸包辺集合 H の辺のうち B に無いものを1本1として、成分を端子とする
+// 格子上の Steiner 木を Dreyfus-Wagner の DP で求める
+//   dp[mask][v] : 成分の集合 mask と頂点 v をつなぐ木の重さの最小値
+// mask ごとに、部分集合2つの木を v でつなぐ場合を調べたあと、
+// 重さ0と1の辺で 0-1 BFS をして v を動かす
+// 最適な Steiner 木は端子の外接長方形からはみ出さないので、H の中だけで探せば足りる
+int calcSteinerEdges(const set<Edge> &B, const set<Edge> &H)
 {
-    vector<vector<int>> dotVector2D = dotstrTo2DVector(dotstr);
-    BoundaryGraph bg;
-    bg.build(dotVector2D);
-
-    // dotVector2Dから境界辺集合を得る
-    set<Edge> Bnd = calcBoundaryEdgeSet(dotVector2D);
+    const int V = 81;
+    auto id = [](const Point &p) { return p.y * 9 + p.x; };
 
-    // 境界辺集合から凸包辺集合を得る
-    set<Edge> H = calcConvexHullEdgeSet(Bnd);
-
-    // 凸包辺集合Hから未使用辺集合Nを得る（NはHとBの差集合）
-    set<Edge> N;
-    set_difference(H.begin(), H.end(), Bnd.begin(), Bnd.end(),
-                   inserter(N, N.begin()));
-
-    vector<Edge> NV(N.begin(), N.end());
-    int n = NV.size();
-
-    int maxDepth = 3;
-    for (int k = 0; k <= maxDepth; k++)
+    // 境界辺で成分に分ける
+    vector<int> comp(V, -1);
+    vector<vector<int>> bnd_adj(V);
+    for (const auto &e : B)
     {
-        if (k > n)
-            break;
-
-        // n個からk個選ぶ組み合わせを next_permutation で生成
-        // 0をn-k個、1をk個並べた配列を用意し、辞書順に並べ替える
-        vector<int> selector(n);
-        fill(selector.begin(), selector.begin() + n - k, 0);
-        fill(selector.begin() + n - k, selector.end(), 1);
-
-        do
+        bnd_adj[id(e.p1)].push_back(id(e.p2));
+        bnd_adj[id(e.p2)].push_back(id(e.p1));
+    }
+    int k = 0;
+    for (int s = 0; s < V; s++)
+    {
+        if (bnd_adj[s].empty() || comp[s] >= 0)
+            continue;
+        vector<int> stack = {s};
+        comp[s] = k;
+        while (!stack.empty())
         {
-            vector<Edge> edges;
-            for (int i = 0; i < n; ++i)
+            int u = stack.back();
+            stack.pop_back();
+            for (int v : bnd_adj[u])
             {
-                if (selector[i])
+                if (comp[v] < 0)
                 {
-                    edges.push_back(NV[i]);
-                    // NV[i] が選ばれた辺。ここに処理を記述
+                    comp[v] = k;
+                    stack.push_back(v);
                 }
             }
+        }
+        k++;
+    }
+    if (k <= 1)
+        return 0;
 
-            for (auto e : edges)
-            {
-                bg.addEdge(e.p1.x, e.p1.y, e.p2.x, e.p2.y);
-            }
-            if (bg.isConnected())
+    // H の辺の重さ（境界辺なら0）
+    vector<vector<pair<int, int>>> adj(V);
+    for (const auto &e : H)
+    {
+        int w = B.count(e) ? 0 : 1;
+        adj[id(e.p1)].push_back({id(e.p2), w});
+        adj[id(e.p2)].push_back({id(e.p1), w});
+    }
+
+    const int INF = INT_MAX / 2;
+    int full = (1 << k) - 1;
+    vector<int> dp((size_t)(full + 1) * V, INF);
+    for (int mask = 1; mask <= full; mask++)
+    {
+        int *d = &dp[(size_t)mask * V];
+        if ((mask & (mask - 1)) == 0)
+        {
+            int c = __builtin_ctz(mask);
+            for (int v = 0; v < V; v++)
+                if (comp[v] == c)
+                    d[v] = 0;
+        }
+        else
+        {
+            // mask の最小の成分を含む真部分集合 sub と、残り mask ^ sub に分ける
+            int low = mask & -mask;
+            for (int sub = (mask - 1) & mask; sub > 0; sub = (sub - 1) & mask)
             {
-                return bg.total_edges + k;
+                if ((sub & low) == 0)
+                    continue;
+                const int *a = &dp[(size_t)sub * V];
+                const int *b = &dp[(size_t)(mask ^ sub) * V];
+                for (int v = 0; v < V; v++)
+                    d[v] = min(d[v], a[v] + b[v]);
             }
-            else
+        }
+
+        // 0-1 BFS
+        deque<int> q;
+        for (int v = 0; v < V; v++)
+            if (d[v] < INF)
+                q.push_back(v);
+        while (!q.empty())
+        {
+            int u = q.front();
+            q.pop_front();
+            for (auto [v, w] : adj[u])
             {
-                for (auto e : edges)
-                    bg.removeEdge(e);
+                if (d[u] + w >= d[v])
+                    continue;
+                d[v] = d[u] + w;
+                if (w == 0)
+                    q.push_front(v);
+                else
+                    q.push_back(v);
             }
-
-        } while (next_permutation(selector.begin(), selector.end()));
+        }
     }
-    return INT_MAX;
+
+    int best = INF;
+    for (int v = 0; v < V; v++)
+        best = min(best, dp[(size_t)full * V + v]);
+    return best;
+}
+
+// ループ長：境界辺の数と、成分をつなぐ辺（行きと帰りで2回ずつ通る）の数の和
+int calcLoopLength(string dotstr)
+{
+    vector<vector<int>> dotVector2D = dotstrTo2DVector(dotstr);
+
+    // dotVector2Dから境界辺集合を得る
+    set<Edge> Bnd = calcBoundaryEdgeSet(dotVector2D);
+
+    // 境界辺集合から凸包辺集合を得る
+    set<Edge> H = calcConvexHullEdgeSet(Bnd);
+
+    return Bnd.size() + 2 * calcSteinerEdges(Bnd, H);
+}
+
+// ループを列挙する前に、ドット絵だけで分かる必要条件を調べる
+// 破れていれば、どの条件で棄却したかを出力して false を返す
+bool passDotPrefilter(string dotstr, int loopLength)
+{
+    DotReject r = check_dot_art(dotstrTo2DVector(dotstr), loopLength);
+    if (r == DotReject::NONE)
+        return true;
+
+    cout << "Rejected by " << dot_reject_name(r) << " condition" << endl;
+    cout << "No CP" << endl;
+    return false;
 }
 
 //
@@ -653,7 +819,10 @@ int main(int argc, char *argv[])
     if (argc != 1)
     {
         mode = string(argv[1]);
-        dotstr = string(argv[2]);
+        if (argc >= 3)
+        {
+            dotstr = string(argv[2]);
+        }
         if (argc >= 4)
         {
             skip = std::stoi(argv[3]);
@@ -675,9 +844,52 @@ int main(int argc, char *argv[])
         int loopLength = calcLoopLength(dotstr);
         cout << "LOOP_LENGTH: " << loopLength << endl;
 
-        findCP_old(dotstr, skip);
+        // 結果の表のファイルは最初に引いたときに開く
+        ResultCache cache(GetResultCachePath());
+        if (passDotPrefilter(dotstr, loopLength))
+            findCP_by_loop(dotstr, cache);
+        // findCP_old(dotstr, skip);
         // findCP(dotstr, skip);
     }
 
+    // 折り割り当てを列挙してCPを探すモード
+    if (mode == "-mode=findCP_old")
+    {
+        cout << "--- Search CP ---" << endl;
+
+        int loopLength = calcLoopLength(dotstr);
+        cout << "LOOP_LENGTH: " << loopLength << endl;
+
+        if (passDotPrefilter(dotstr, loopLength))
+            findCP_old(dotstr, skip);
+    }
+
+    // 各段を並行に動かして、最初に見つかったCPを返すモード
+    if (mode == "-mode=findCP_pipeline")
+    {
+        cout << "--- Search CP ---" << endl;
+
+        int loopLength = calcLoopLength(dotstr);
+        cout << "LOOP_LENGTH: " << loopLength << endl;
+
+        if (passDotPrefilter(dotstr, loopLength))
+            findCP_pipeline(dotstr);
+    }
+
+    // 内側5x5の判定表を作り直して保存するモード
+    if (mode == "-mode=buildOracle")
+    {
+        InteriorOracle oracle;
+        oracle.build();
+        string path = GetOraclePath();
+        if (!oracle.save(path))
+        {
+            cerr << "Failed to save " << path << endl;
+            return 1;
+        }
+        cout << "ORACLE: " << oracle.get_num_nodes() << " nodes, "
+             << oracle.get_num_edges() << " edges" << endl;
+    }
+
     return 0;
 }
\ No newline at end of file
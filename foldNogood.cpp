@@ -0,0 +1,138 @@
+#include "foldNogood.h"
+#include "tileDomain.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+// 1つの外周頂点の折り方を3bitで詰めるので、64bitに入るのは21個まで
+const int MAX_NOGOOD_SIZE = 21;
+
+FoldNogood::FoldNogood(int max_trials) : max_trials(max_trials) {}
+
+// mask の外周頂点の折り方を番号の小さい順に3bitずつ詰める
+// 表に無い折り方を含む場合は false
+bool FoldNogood::get_key(uint32_t mask, const array<int, 32> &folds,
+                         uint64_t &key) const {
+    key = 0;
+    for (uint32_t m = mask; m != 0; m &= m - 1) {
+        int out = __builtin_ctz(m);
+        int f = folds[out];
+        int code = (0 <= f && f < 9) ? FOLD_CODE[f] : -1;
+        if (code == -1)
+            return false;
+        key = (key << 3) | code;
+    }
+    return true;
+}
+
+// セル 0..dead_cell に制限をかける外周頂点の集合
+uint32_t FoldNogood::get_prefix_mask(int dead_cell) const {
+    uint32_t mask = 0;
+    for (int out = 0; out < 32; out++) {
+        for (int j = 0; j < 3; j++) {
+            int cell = FOLD_TILE_MASK.cell[out][j];
+            if (cell != -1 && cell <= dead_cell)
+                mask |= 1u << out;
+        }
+    }
+    return mask;
+}
+
+// mask の外周頂点の折り方だけで制限したときの各セルのタイルの集合
+array<uint64_t, 49>
+FoldNogood::create_domain(uint32_t mask, const array<int, 32> &folds) const {
+    array<uint64_t, 49> domain = BASE_TILE_DOMAIN;
+    for (uint32_t m = mask; m != 0; m &= m - 1) {
+        int out = __builtin_ctz(m);
+        for (int j = 0; j < 3; j++) {
+            int cell = FOLD_TILE_MASK.cell[out][j];
+            if (cell != -1)
+                domain[cell] &= FOLD_TILE_MASK.mask[out][folds[out]][j];
+        }
+    }
+    return domain;
+}
+
+// 学習済みの nogood を含む折り割り当てなら true
+bool FoldNogood::contains(const array<int, 32> &folds) {
+    checked++;
+    for (const auto &[mask, keys] : table) {
+        uint64_t key;
+        if (get_key(mask, folds, key) && keys.count(key)) {
+            rejected++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 直前の c.hasCP() で失敗した折り割り当て folds から nogood を学習する
+// c のタイルの集合は書き換わる
+void FoldNogood::learn(Counter &c, const array<int, 32> &folds) {
+    learn(c, folds, c.get_dead_cell());
+}
+
+// c 以外（InteriorOracle など）で失敗した折り割り当て folds から
+// nogood を学習する。dead_cell は全滅したセル
+void FoldNogood::learn(Counter &c, const array<int, 32> &folds,
+                       int dead_cell) {
+    if (dead_cell == -1)
+        return;
+
+    uint32_t mask = get_prefix_mask(dead_cell);
+
+    // 全滅したセルから遠い外周頂点ほど原因ではなさそうなので先に外してみる
+    auto distance = [&](int out) {
+        int d = 0;
+        for (int j = 0; j < 3; j++) {
+            int cell = FOLD_TILE_MASK.cell[out][j];
+            if (cell == -1)
+                continue;
+            int dx = abs(cell % 7 - dead_cell % 7);
+            int dy = abs(cell / 7 - dead_cell / 7);
+            d = max(d, max(dx, dy));
+        }
+        return d;
+    };
+    vector<int> order;
+    for (uint32_t m = mask; m != 0; m &= m - 1)
+        order.push_back(__builtin_ctz(m));
+    stable_sort(order.begin(), order.end(),
+                [&](int a, int b) { return distance(a) > distance(b); });
+
+    int trials = 0;
+    for (int out : order) {
+        if (trials >= max_trials)
+            break;
+        if (((mask >> out) & 1) == 0)
+            continue;
+
+        // out の制限を外しても失敗するなら out は原因ではない
+        // DPは全滅したセルまでしか行わない
+        uint32_t relaxed = mask & ~(1u << out);
+        trials++;
+        c.setTileDomain(create_domain(relaxed, folds));
+        if (c.hasCP(dead_cell + 1))
+            continue;
+        dead_cell = c.get_dead_cell();
+        mask = relaxed & get_prefix_mask(dead_cell);
+    }
+
+    if (__builtin_popcount(mask) > MAX_NOGOOD_SIZE)
+        return;
+
+    uint64_t key;
+    if (!get_key(mask, folds, key))
+        return;
+    if (table[mask].insert(key).second)
+        learned++;
+}
+
+void FoldNogood::print_stats(const string &label) const {
+    cout << label << "Nogood rejected: " << rejected << " / " << checked
+         << " (learned " << learned << ", " << table.size() << " masks)"
+         << endl;
+}
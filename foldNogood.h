@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ftcp.h"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// DPで平坦折り不可能と分かった折り割り当てから、失敗の原因となる外周頂点の
+// 部分集合（nogood）を学習し、同じ部分割り当てを含む折り割り当てを
+// DPにかけずに棄却するための表
+//
+// DPはセル番号の順にタイルを置くので、セル k で全滅したときは
+// セル 0..k に制限をかける外周頂点の折り方だけで失敗が決まる
+// さらに外周頂点の制限を1つずつ外してDPをやり直し、
+// それでも失敗するなら外した外周頂点を nogood から除く
+class FoldNogood {
+    // key_mask ごとに、key_mask の外周頂点の折り方を詰めた値の集合
+    std::map<std::uint32_t, std::unordered_set<std::uint64_t>> table;
+
+    int max_trials;
+
+    bool get_key(std::uint32_t mask, const std::array<int, 32> &folds,
+                 std::uint64_t &key) const;
+    std::uint32_t get_prefix_mask(int dead_cell) const;
+    std::array<std::uint64_t, 49>
+    create_domain(std::uint32_t mask, const std::array<int, 32> &folds) const;
+
+  public:
+    unsigned long long checked = 0;
+    unsigned long long rejected = 0;
+    unsigned long long learned = 0;
+
+    // max_trials : 1つの nogood を小さくするために DP をやり直す最大回数
+    //              (やり直しのDPは制限が緩いぶん重いので、既定では行わない)
+    FoldNogood(int max_trials = 0);
+    bool contains(const std::array<int, 32> &folds);
+    void learn(Counter &c, const std::array<int, 32> &folds);
+    void learn(Counter &c, const std::array<int, 32> &folds, int dead_cell);
+    void print_stats(const std::string &label) const;
+};
@@ -0,0 +1,172 @@
+#include "foldPrefilter.h"
+#include "tileDomain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+using namespace std;
+
+const int DX[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+const int DY[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+// 内部頂点 cell に制限をかける外周頂点
+static vector<int> get_outers(int cell) {
+    vector<int> outers;
+    for (int out = 0; out < 32; out++) {
+        for (int j = 0; j < 3; j++) {
+            if (FOLD_TILE_MASK.cell[out][j] == cell)
+                outers.push_back(out);
+        }
+    }
+    return outers;
+}
+
+// outers の折り方が values のときの内部頂点 cell に置けるタイル
+static uint64_t get_domain(int cell, const vector<int> &outers,
+                           const vector<int> &values) {
+    uint64_t domain = BASE_TILE_DOMAIN[cell];
+    for (size_t i = 0; i < outers.size(); i++) {
+        for (int j = 0; j < 3; j++) {
+            if (FOLD_TILE_MASK.cell[outers[i]][j] == cell)
+                domain &= FOLD_TILE_MASK.mask[outers[i]][values[i]][j];
+        }
+    }
+    return domain;
+}
+
+// 外周頂点の列に対し、折り方のすべての組み合わせで judge を評価した表を作る
+template <class F>
+static void fill_table(const vector<int> &outers, vector<unsigned char> &ok,
+                       F judge) {
+    int size = 1;
+    for (size_t i = 0; i < outers.size(); i++)
+        size *= 5;
+
+    ok.assign(size, 0);
+    vector<int> values(outers.size());
+    for (int key = 0; key < size; key++) {
+        int k = key;
+        for (size_t i = 0; i < outers.size(); i++) {
+            values[i] = FOLD_VALUES[k % 5];
+            k /= 5;
+        }
+        ok[key] = judge(values);
+    }
+}
+
+FoldPrefilter::FoldPrefilter() {
+    // 外周に接する内部頂点
+    vector<int> ring;
+    for (int cell = 0; cell < 49; cell++) {
+        int x = cell % 7;
+        int y = cell / 7;
+        if (x == 0 || x == 6 || y == 0 || y == 6)
+            ring.push_back(cell);
+    }
+
+    // 各内部頂点にタイルが置けるか
+    for (int cell : ring) {
+        Table t;
+        t.outers = get_outers(cell);
+        fill_table(t.outers, t.ok, [&](const vector<int> &values) {
+            return get_domain(cell, t.outers, values) != 0;
+        });
+        cellTables.push_back(t);
+    }
+
+    // 隣り合う内部頂点の組（外周に沿って隣接するものと、カド付近で斜めに隣接するもの）
+    for (int c1 : ring) {
+        for (int d = 0; d < 8; d++) {
+            int x = c1 % 7 + DX[d];
+            int y = c1 / 7 + DY[d];
+            if (x < 0 || x > 6 || y < 0 || y > 6)
+                continue;
+            int c2 = x + y * 7;
+            if (c2 < c1 || find(ring.begin(), ring.end(), c2) == ring.end())
+                continue;
+
+            vector<int> o1 = get_outers(c1);
+            vector<int> o2 = get_outers(c2);
+
+            Table t;
+            t.outers = o1;
+            for (int out : o2) {
+                auto it = find(t.outers.begin(), t.outers.end(), out);
+                if (it == t.outers.end())
+                    t.outers.push_back(out);
+            }
+
+            fill_table(t.outers, t.ok, [&](const vector<int> &values) {
+                auto value_of = [&](int out) {
+                    auto it = find(t.outers.begin(), t.outers.end(), out);
+                    return values[it - t.outers.begin()];
+                };
+                vector<int> v1, v2;
+                for (int out : o1)
+                    v1.push_back(value_of(out));
+                for (int out : o2)
+                    v2.push_back(value_of(out));
+                uint64_t d1 = get_domain(c1, o1, v1);
+                uint64_t d2 = get_domain(c2, o2, v2);
+
+                // 共有する辺の値が一致するタイルの組があるか
+                int rd = (d + 4) % 8;
+                for (int e = 0; e < 2; e++) {
+                    if ((d1 & DIR_TILE_MASK.mask[d][e]) &&
+                        (d2 & DIR_TILE_MASK.mask[rd][e]))
+                        return true;
+                }
+                return false;
+            });
+            pairTables.push_back(t);
+        }
+    }
+}
+
+int FoldPrefilter::get_key(const Table &t, const array<int, 32> &folds) const {
+    int key = 0;
+    for (int i = (int)t.outers.size() - 1; i >= 0; i--) {
+        int f = folds[t.outers[i]];
+        int code = (0 <= f && f < 9) ? FOLD_CODE[f] : -1;
+        if (code == -1)
+            return -1;
+        key = key * 5 + code;
+    }
+    return key;
+}
+
+// 局所的な矛盾が無ければ true
+bool FoldPrefilter::check(const array<int, 32> &folds) {
+    checked++;
+
+    // 表に無い折り方を含む場合は判定しない
+    for (const Table &t : cellTables) {
+        int key = get_key(t, folds);
+        if (key != -1 && !t.ok[key]) {
+            rejected++;
+            return false;
+        }
+    }
+
+    for (const Table &t : pairTables) {
+        int key = get_key(t, folds);
+        if (key != -1 && !t.ok[key]) {
+            rejected++;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FoldPrefilter::reset() {
+    checked = 0;
+    rejected = 0;
+}
+
+void FoldPrefilter::print_stats(const string &label) const {
+    double rate = checked == 0 ? 0.0 : 100.0 * rejected / checked;
+    cout << label << "Prefilter rejected: " << rejected << " / " << checked
+         << " (" << rate << "%)" << endl;
+}
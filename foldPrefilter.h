@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+// 折り割り当てをDPにかける前に、外周付近の局所的な矛盾で棄却するフィルタ
+// ・外周に接する内部頂点に置けるタイルが無い
+// ・隣り合う外周の内部頂点同士で、共有する辺の値が一致するタイルの組が無い
+// の2つを、連続する外周頂点の折り方をキーとする表で判定する
+class FoldPrefilter {
+    // 判定に使う外周頂点の列と、その折り方の組み合わせごとの判定結果
+    struct Table {
+        std::vector<int> outers;
+        std::vector<unsigned char> ok;
+    };
+
+    std::vector<Table> cellTables;
+    std::vector<Table> pairTables;
+
+    int get_key(const Table &t, const std::array<int, 32> &folds) const;
+
+  public:
+    unsigned long long checked = 0;
+    unsigned long long rejected = 0;
+
+    FoldPrefilter();
+    bool check(const std::array<int, 32> &folds);
+    void reset();
+    void print_stats(const std::string &label) const;
+};
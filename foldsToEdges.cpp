@@ -1,7 +1,10 @@
 #include <array>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
+#include "tileDomain.h"
+
 using namespace std;
 
 #define UP 0
@@ -176,4 +179,25 @@ array<int, 398> create_edges_by_folds_arr(array<int, 32> &folds) {
     }
 
     return edges;
-}
\ No newline at end of file
+}
+
+// 折り割り当てから各内部頂点に置けるタイルの集合を得る
+// create_edges_by_folds と Counter::setTileCondition を合わせた処理を
+// コンパイル時に計算した表の AND だけで行う
+array<uint64_t, 49> create_tile_domain_by_folds(const array<int, 32> &folds) {
+    array<uint64_t, 49> domain = BASE_TILE_DOMAIN;
+
+    for (int i = 0; i < 32; i++) {
+        if (i % 8 == 0)
+            continue;
+
+        const uint64_t *mask = FOLD_TILE_MASK.mask[i][folds[i]];
+        const int *cell = FOLD_TILE_MASK.cell[i];
+        for (int j = 0; j < 3; j++) {
+            if (cell[j] != -1)
+                domain[cell[j]] &= mask[j];
+        }
+    }
+
+    return domain;
+}
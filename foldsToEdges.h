@@ -2,11 +2,13 @@
 #define FOLDSTOEDGES_H
 
 #include <array>
+#include <cstdint>
 #include <vector>
 using namespace std;
 
 vector<int> create_edges_by_folds(array<int, 32> &folds);
 array<int, 398> create_edges_by_folds_arr(array<int, 32> &folds);
+array<uint64_t, 49> create_tile_domain_by_folds(const array<int, 32> &folds);
 
 int get_edge_from_fold(int f, int n);
 
@@ -1,7 +1,14 @@
+#ifdef _WIN32
 #include <windows.h> //最優先で読み込む必要がある
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 #include "foldsToEdges.h"
 #include "ftcp.h"
+#include "tileDomain.h"
 
 #include <omp.h>
 #include <sys/time.h>
@@ -13,12 +20,10 @@
 #include <chrono>
 #include <cstdint>
 #include <deque>
-#include <format>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <map>
-#include <psapi.h>
 #include <regex>
 #include <string>
 #include <vector>
@@ -46,25 +51,7 @@ const int DIRECTIONS[8][2] = {
     {-1, -1} // UL
 };
 
-const int TILE[36][8] = {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 1, 0, 0, 0, 1},
-                         {0, 0, 1, 0, 0, 0, 1, 0}, {0, 0, 1, 0, 0, 1, 1, 1},
-                         {0, 0, 1, 0, 1, 1, 0, 1}, {0, 0, 1, 1, 1, 0, 0, 1},
-                         {0, 1, 0, 0, 0, 1, 0, 0}, {0, 1, 0, 0, 1, 0, 1, 1},
-                         {0, 1, 0, 0, 1, 1, 1, 0}, {0, 1, 0, 1, 0, 1, 0, 1},
-                         {0, 1, 0, 1, 1, 0, 1, 0}, {0, 1, 0, 1, 1, 1, 1, 1},
-                         {0, 1, 1, 0, 1, 0, 0, 1}, {0, 1, 1, 1, 0, 0, 1, 0},
-                         {0, 1, 1, 1, 0, 1, 1, 1}, {0, 1, 1, 1, 1, 1, 0, 1},
-                         {1, 0, 0, 0, 1, 0, 0, 0}, {1, 0, 0, 1, 0, 0, 1, 1},
-                         {1, 0, 0, 1, 0, 1, 1, 0}, {1, 0, 0, 1, 1, 1, 0, 0},
-                         {1, 0, 1, 0, 0, 1, 0, 1}, {1, 0, 1, 0, 1, 0, 1, 0},
-                         {1, 0, 1, 0, 1, 1, 1, 1}, {1, 0, 1, 1, 0, 1, 0, 0},
-                         {1, 0, 1, 1, 1, 0, 1, 1}, {1, 0, 1, 1, 1, 1, 1, 0},
-                         {1, 1, 0, 0, 1, 0, 0, 1}, {1, 1, 0, 1, 0, 0, 1, 0},
-                         {1, 1, 0, 1, 0, 1, 1, 1}, {1, 1, 0, 1, 1, 1, 0, 1},
-                         {1, 1, 1, 0, 0, 1, 0, 0}, {1, 1, 1, 0, 1, 0, 1, 1},
-                         {1, 1, 1, 0, 1, 1, 1, 0}, {1, 1, 1, 1, 0, 1, 0, 1},
-                         {1, 1, 1, 1, 1, 0, 1, 0}, {1, 1, 1, 1, 1, 1, 1, 1}};
-
+#ifdef _WIN32
 void PrintMemoryUsage() {
     // 自身のプロセスハンドルを取得
     HANDLE hProcess = GetCurrentProcess();
@@ -94,12 +81,27 @@ void PrintMemoryUsage() {
         std::cerr << "メモリ情報の取得に失敗しました。" << std::endl;
     }
 }
+#else
+void PrintMemoryUsage() {
+    // Linux ではピークの常駐メモリ量だけを表示する（ru_maxrss は KB）
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        std::cout << "--- メモリ使用量 ---" << std::endl;
+        std::cout << "ピークワーキングセット: " << usage.ru_maxrss << " KB"
+                  << std::endl;
+    } else {
+        std::cerr << "メモリ情報の取得に失敗しました。" << std::endl;
+    }
+}
+#endif
 
 Counter::Counter(int width) {
     w = width;
     mate_size = 3 * w - 1;
     state_size = 1ULL << mate_size;
-    tileConditon = vector<vector<int>>(w * w, vector<int>(36, 1));
+    dead_cell = -1;
+    for (int cell = 0; cell < 49; cell++)
+        tile_domain[cell] = ALL_TILES;
 
     // cell_x, cell_yの初期化
     for (int cell = 0; cell < 49; cell++) {
@@ -135,7 +137,15 @@ Counter::Counter(int width) {
 }
 
 void Counter::setTileCondition(int cell, int tile, int value) {
-    tileConditon[cell][tile] = value;
+    if (value)
+        tile_domain[cell] |= 1ULL << tile;
+    else
+        tile_domain[cell] &= ~(1ULL << tile);
+}
+
+void Counter::setTileDomain(const array<uint64_t, 49> &domain) {
+    for (int cell = 0; cell < w * w; cell++)
+        tile_domain[cell] = domain[cell];
 }
 
 int Counter::get_binary_digit(unsigned long long n, int d) {
@@ -166,13 +176,9 @@ int Counter::get_index(int dir, int x) {
     return 0;
 }
 
-bool Counter::can_put(int cell, int tile, unsigned long long mate) {
-    // preCreaseによって、置いて良いタイルが制限されている場合
-    if (tileConditon[cell][tile] == 0)
-        return false;
-
+// mateからセルの左、左上、上、右上の辺を得る (bit 0,1,2,3)
+uint32_t Counter::get_4_edges(int cell, unsigned long long mate) {
     int x = cell_x[cell];
-    int y = cell_y[cell];
 
     // mateの4方向のindexを得る
     int li, ui, uli, uri;
@@ -187,7 +193,15 @@ bool Counter::can_put(int cell, int tile, unsigned long long mate) {
     mul = get_binary_digit(mate, uli);
     mu = get_binary_digit(mate, ui);
     mur = get_binary_digit(mate, uri);
-    uint32_t m_all = ml | (mul << 1) | (mu << 2) | (mur << 3);
+    return ml | (mul << 1) | (mu << 2) | (mur << 3);
+}
+
+bool Counter::can_put(int cell, int tile, unsigned long long mate) {
+    // preCreaseによって、置いて良いタイルが制限されている場合
+    if (((tile_domain[cell] >> tile) & 1) == 0)
+        return false;
+
+    uint32_t m_all = get_4_edges(cell, mate);
 
     // 接続判定
     if ((m_all & d_mask[cell]) != (tile_4_edges[tile] & d_mask[cell]))
@@ -197,6 +211,12 @@ bool Counter::can_put(int cell, int tile, unsigned long long mate) {
 }
 
 unsigned long long Counter::put(int cell, int take, unsigned long long mate) {
+    return put_edges(cell, TILE[take], mate);
+}
+
+// 8方向の辺の値 edges を持つものをセルに置いたときのmateを得る
+unsigned long long Counter::put_edges(int cell, const int *edges,
+                                      unsigned long long mate) {
     int x = cell % w;
     int y = cell / w;
 
@@ -225,7 +245,7 @@ unsigned long long Counter::put(int cell, int take, unsigned long long mate) {
     int ids[4] = {ri, lli, di, lri};
     for (int i = 0; i < 4; i++) {
         if (updates[i] == 1)
-            mate2 = set_bit(mate2, ids[i], TILE[take][ds[i]]);
+            mate2 = set_bit(mate2, ids[i], edges[ds[i]]);
     }
 
     return mate2;
@@ -259,7 +279,9 @@ unsigned long long Counter::count() {
             if (table[prev][k] == 0)
                 continue;
 
-            for (int j = 0; j < 36; j++) { // タイルjを設置
+            // 置ける可能性のあるタイルjだけを設置
+            for (uint64_t m = tile_domain[i]; m != 0; m &= m - 1) {
+                int j = __builtin_ctzll(m);
 
                 // セルiにタイルjが置けるか？
                 if (!can_put(i, j, k))
@@ -298,7 +320,12 @@ unsigned long long Counter::count() {
 }
 
 // 外周部の割当条件を満たす平坦折り可能な展開図が存在するか判定
-bool Counter::hasCP() {
+// 存在しない場合は、タイルが置けなくなったセルを dead_cell に記録する
+// num_cells を指定すると先頭の num_cells 個のセルまでタイルが置けるかを判定する
+bool Counter::hasCP(int num_cells) {
+    if (num_cells == -1)
+        num_cells = w * w;
+
     // tableの準備
     bool *table = (bool *)malloc(sizeof(bool) * state_size * 2);
 
@@ -308,8 +335,9 @@ bool Counter::hasCP() {
     }
 
     table[0] = true;
+    dead_cell = -1;
 
-    for (int i = 0; i < w * w; i++) {
+    for (int i = 0; i < num_cells; i++) {
         int prev = i % 2;
         int next = (i + 1) % 2;
 
@@ -317,14 +345,19 @@ bool Counter::hasCP() {
         for (unsigned long long k = 0; k < state_size; k++)
             table[next * state_size + k] = false;
 
+        // セルiまで置けるmateが残っているか
+        bool alive = false;
+
 // 各mateの更新
-#pragma omp parallel for schedule(guided)
+#pragma omp parallel for schedule(guided) reduction(|| : alive)
         for (unsigned long long k = 0; k < state_size; k++) {
 
             if (table[prev * state_size + k] == false)
                 continue;
 
-            for (int j = 0; j < 36; j++) { // タイルjを設置
+            // 置ける可能性のあるタイルjだけを設置
+            for (uint64_t m = tile_domain[i]; m != 0; m &= m - 1) {
+                int j = __builtin_ctzll(m);
 
                 // セルiにタイルjが置けるか？
                 if (!can_put(i, j, k))
@@ -335,12 +368,20 @@ bool Counter::hasCP() {
 
                 // 得られたmateへ到達する経路数を加算する
                 table[next * state_size + newstate] = true;
+                alive = true;
             }
         }
+
+        // セルiで全滅したら以降のセルは調べない
+        if (!alive) {
+            dead_cell = i;
+            free(table);
+            return false;
+        }
     }
 
     // 展開図が存在するか
-    int next = w % 2;
+    int next = num_cells % 2;
     unsigned long long row_offset = next * state_size;
     bool has = false;
 
@@ -354,6 +395,8 @@ bool Counter::hasCP() {
     return has;
 }
 
+int Counter::get_dead_cell() { return dead_cell; }
+
 string Counter::findCP() {
 
     // tableの準備
@@ -381,7 +424,9 @@ string Counter::findCP() {
             if (table[prev][k] == "NG")
                 continue;
 
-            for (int j = 0; j < 36; j++) { // タイルjを設置
+            // 置ける可能性のあるタイルjだけを設置
+            for (uint64_t m = tile_domain[i]; m != 0; m &= m - 1) {
+                int j = __builtin_ctzll(m);
 
                 // セルiにタイルjが置けるか？
                 if (!can_put(i, j, k))
@@ -438,6 +483,7 @@ string Counter::to_str(int a) {
     return ans;
 }
 
+#ifdef _WIN32
 std::string GetExeDirectory() {
     char path[MAX_PATH];
     // GetModuleFileNameA:
@@ -469,6 +515,22 @@ std::string GetExeDirectory() {
 
     return ""; // 見つからなかった場合
 }
+#else
+std::string GetExeDirectory() {
+    // /proc/self/exe が実行ファイルのフルパスを指している
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0)
+        return "";
+    path[length] = '\0';
+
+    std::string fullPath(path);
+    size_t last_slash = fullPath.find_last_of('/');
+    if (last_slash != std::string::npos)
+        return fullPath.substr(0, last_slash + 1);
+    return "";
+}
+#endif
 
 void writeToFile(string output_path, string output_txt) {
     // 1. std::ofstream オブジェクトを作成し、ファイル名を与える
@@ -502,18 +564,13 @@ void writeToFile(string output_path, string output_txt) {
 void Counter::setTileCondition(vector<vector<int>> &preEdges) {
     // 各マスに置く可能性のあるタイルを設定
     for (int i = 0; i < w * w; i++) {
-        for (int t = 0; t < 36; t++) {
-            bool puttable = true;
-            for (int d = 0; d < 8; d++) {
-                if (preEdges[i][d] == -1)
-                    continue;
-                if (preEdges[i][d] != TILE[t][d]) {
-                    puttable = false;
-                    break;
-                }
-            }
-            setTileCondition(i, t, puttable);
+        uint64_t domain = ALL_TILES;
+        for (int d = 0; d < 8; d++) {
+            if (preEdges[i][d] == -1)
+                continue;
+            domain &= DIR_TILE_MASK.mask[d][preEdges[i][d]];
         }
+        tile_domain[i] = domain;
     }
 }
 
@@ -544,6 +601,16 @@ string Counter::edges_to_cpstr(vector<int> &innerVerticesState) {
     return findCP();
 }
 
+// 各内部頂点に置けるタイルの集合から展開図を生成する
+string Counter::domain_to_cpstr(const array<uint64_t, 49> &domain) {
+    setTileDomain(domain);
+
+    bool has = hasCP();
+    if (!has)
+        return "No CP";
+    return findCP();
+}
+
 void print_edges_state(vector<int> edges) {
     for (int i = 0; i < 49; i++) {
         for (int j = 0; j < 8; j++) {
@@ -554,9 +621,9 @@ void print_edges_state(vector<int> edges) {
 }
 
 string folds_to_cpstr(array<int, 32> &folds) {
-    vector<int> edges = create_edges_by_folds(folds);
+    array<uint64_t, 49> domain = create_tile_domain_by_folds(folds);
     Counter c(7);
-    return c.edges_to_cpstr(edges);
+    return c.domain_to_cpstr(domain);
 }
 
 #if 0
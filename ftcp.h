@@ -9,11 +9,12 @@ class Counter {
     int w;
     int mate_size;
     unsigned long long state_size;
-    std::vector<std::vector<int>> tileConditon;
+    std::uint64_t tile_domain[49]; // 各マスに置けるタイルの集合 (36bit)
     std::uint32_t d_mask[49];
     std::uint32_t tile_4_edges[49];
     int cell_x[49];
     int cell_y[49];
+    int dead_cell; // 直前の hasCP でタイルが置けなくなったセル（無ければ -1）
 
   public:
     Counter(int width);
@@ -21,14 +22,20 @@ class Counter {
     int get_binary_digit(unsigned long long n, int d);
     unsigned long long set_bit(unsigned long long n, int d, int v);
     int get_index(int dir, int x);
+    std::uint32_t get_4_edges(int cell, unsigned long long mate);
     bool can_put(int cell, int tile, unsigned long long mate);
     unsigned long long put(int cell, int take, unsigned long long mate);
+    unsigned long long put_edges(int cell, const int *edges,
+                                 unsigned long long mate);
     unsigned long long count();
-    bool hasCP();
+    bool hasCP(int num_cells = -1);
+    int get_dead_cell();
     std::string findCP();
     std::string to_str(int a);
     void setTileCondition(std::vector<std::vector<int>> &preEdges);
+    void setTileDomain(const std::array<std::uint64_t, 49> &domain);
     std::string edges_to_cpstr(std::vector<int> &innerVerticesState);
+    std::string domain_to_cpstr(const std::array<std::uint64_t, 49> &domain);
 };
 
 void PrintMemoryUsage();
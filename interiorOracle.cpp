@@ -0,0 +1,411 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "interiorOracle.h"
+#include "tileDomain.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+
+using namespace std;
+
+const uint32_t ORACLE_MAGIC = 0x3152494f; // "OIR1"
+const int NUM_LEVELS = 25;
+const int MATE_BITS = 20;
+const uint64_t MATE_MASK = (1ULL << MATE_BITS) - 1;
+
+// 内側のセル (5x5) と7x7のセルの対応
+static int to_outer_cell(int cell) { return (cell % 5 + 1) + (cell / 5 + 1) * 7; }
+
+static bool is_ring_cell(int cell) {
+    int x = cell % 7;
+    int y = cell / 7;
+    return x == 0 || x == 6 || y == 0 || y == 6;
+}
+
+struct SetHash {
+    size_t operator()(const vector<unsigned long long> &v) const {
+        size_t h = v.size();
+        for (unsigned long long x : v)
+            h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+InteriorOracle::InteriorOracle() : counter(7) {
+    // 左、左上、上、右上の辺の mate 上の bit
+    int check_bit[8] = {2, 3, -1, -1, -1, -1, 0, 1};
+
+    for (int cell = 0; cell < 25; cell++) {
+        int x = cell % 5;
+        int y = cell / 5;
+
+        // 外周セルへ延びる辺の方向（小さい順）
+        bool out[8] = {};
+        if (y == 0)
+            out[7] = out[0] = out[1] = true;
+        if (x == 0)
+            out[5] = out[6] = out[7] = true;
+        if (x == 4)
+            out[1] = out[2] = out[3] = true;
+        if (y == 4)
+            out[3] = out[4] = out[5] = true;
+        num_out_dirs[cell] = 0;
+        for (int d = 0; d < 8; d++) {
+            if (out[d])
+                out_dirs[cell][num_out_dirs[cell]++] = d;
+        }
+
+        for (int label = 0; label < 32; label++) {
+            check_mask[cell][label] = 0;
+            check_value[cell][label] = 0;
+            for (int d = 0; d < 8; d++)
+                put_edge[cell][label][d] = 0;
+
+            for (int k = 0; k < num_out_dirs[cell]; k++) {
+                int d = out_dirs[cell][k];
+                int v = (label >> k) & 1;
+                if (check_bit[d] != -1) {
+                    check_mask[cell][label] |= 1u << check_bit[d];
+                    check_value[cell][label] |= (uint32_t)v << check_bit[d];
+                } else {
+                    put_edge[cell][label][d] = v;
+                }
+            }
+        }
+    }
+}
+
+InteriorOracle::~InteriorOracle() { unmap(); }
+
+// 表を計算する（数十秒かかる）
+void InteriorOracle::build() {
+    unmap();
+
+    Counter c(5);
+
+    // 前から: 層ごとの内側のmateの集合と、ラベルつきの辺 (ノード, ラベル, 子)
+    vector<vector<vector<unsigned long long>>> sets(NUM_LEVELS + 1);
+    vector<vector<array<uint32_t, 3>>> forward(NUM_LEVELS);
+    vector<int> level_size(NUM_LEVELS + 1);
+    sets[0] = {{0}};
+
+    for (int cell = 0; cell < NUM_LEVELS; cell++) {
+        unordered_map<vector<unsigned long long>, uint32_t, SetHash> index;
+        vector<vector<unsigned long long>> next;
+
+        for (uint32_t node = 0; node < sets[cell].size(); node++) {
+            vector<unsigned long long> by_label[32];
+            for (unsigned long long mate : sets[cell][node]) {
+                for (int tile = 0; tile < 36; tile++) {
+                    if (!c.can_put(cell, tile, mate))
+                        continue;
+                    int label = 0;
+                    for (int k = 0; k < num_out_dirs[cell]; k++)
+                        label |= TILE[tile][out_dirs[cell][k]] << k;
+                    by_label[label].push_back(c.put(cell, tile, mate));
+                }
+            }
+
+            for (int label = 0; label < 32; label++) {
+                vector<unsigned long long> &s = by_label[label];
+                if (s.empty())
+                    continue;
+                sort(s.begin(), s.end());
+                s.erase(unique(s.begin(), s.end()), s.end());
+
+                auto it = index.find(s);
+                uint32_t child;
+                if (it == index.end()) {
+                    child = next.size();
+                    index.emplace(s, child);
+                    next.push_back(s);
+                } else {
+                    child = it->second;
+                }
+                forward[cell].push_back({node, (uint32_t)label, child});
+            }
+        }
+
+        level_size[cell] = sets[cell].size();
+        sets[cell].clear();
+        sets[cell].shrink_to_fit();
+        sets[cell + 1] = move(next);
+    }
+    level_size[NUM_LEVELS] = sets[NUM_LEVELS].size();
+
+    // 後ろから: 最後まで到達できないノードを除き、同じ遷移を持つノードをまとめる
+    // 最後の層はすべて受理なので1つの終端ノードにする
+    vector<vector<int>> cls(NUM_LEVELS + 1);
+    vector<vector<vector<uint32_t>>> class_edges(NUM_LEVELS + 1);
+    cls[NUM_LEVELS].assign(level_size[NUM_LEVELS], 0);
+    class_edges[NUM_LEVELS].resize(1);
+
+    for (int cell = NUM_LEVELS - 1; cell >= 0; cell--) {
+        int n = level_size[cell];
+
+        vector<vector<uint32_t>> sig(n);
+        for (auto &e : forward[cell]) {
+            int child = cls[cell + 1][e[2]];
+            if (child != -1)
+                sig[e[0]].push_back(((uint32_t)child << 5) | e[1]);
+        }
+
+        cls[cell].assign(n, -1);
+        map<vector<uint32_t>, int> index;
+        for (int node = 0; node < n; node++) {
+            if (sig[node].empty())
+                continue;
+            auto it = index.find(sig[node]);
+            if (it == index.end()) {
+                int id = class_edges[cell].size();
+                index.emplace(sig[node], id);
+                class_edges[cell].push_back(sig[node]);
+                cls[cell][node] = id;
+            } else {
+                cls[cell][node] = it->second;
+            }
+        }
+        forward[cell].clear();
+        forward[cell].shrink_to_fit();
+    }
+
+    // 通し番号をつけて並べる
+    vector<uint32_t> level_offset(NUM_LEVELS + 2, 0);
+    for (int cell = 0; cell <= NUM_LEVELS; cell++)
+        level_offset[cell + 1] = level_offset[cell] + class_edges[cell].size();
+    uint32_t n_nodes = level_offset[NUM_LEVELS + 1];
+    uint32_t n_edges = 0;
+    for (int cell = 0; cell < NUM_LEVELS; cell++) {
+        for (auto &s : class_edges[cell])
+            n_edges += s.size();
+    }
+
+    storage.clear();
+    storage.push_back(ORACLE_MAGIC);
+    storage.push_back(n_nodes);
+    storage.push_back(n_edges);
+    for (int cell = 0; cell <= NUM_LEVELS; cell++)
+        storage.push_back(level_offset[cell]);
+    uint32_t e = 0;
+    for (int cell = 0; cell <= NUM_LEVELS; cell++) {
+        for (auto &s : class_edges[cell]) {
+            storage.push_back(e);
+            e += s.size();
+        }
+    }
+    storage.push_back(e);
+    for (int cell = 0; cell < NUM_LEVELS; cell++) {
+        for (auto &s : class_edges[cell]) {
+            for (uint32_t edge : s) {
+                uint32_t child = (edge >> 5) + level_offset[cell + 1];
+                storage.push_back((child << 5) | (edge & 31));
+            }
+        }
+    }
+
+    attach(storage.data(), storage.size() * sizeof(uint32_t));
+}
+
+// 表の中身の位置を設定する
+bool InteriorOracle::attach(const uint32_t *data, size_t size) {
+    if (size < 3 * sizeof(uint32_t) || data[0] != ORACLE_MAGIC)
+        return false;
+    uint32_t n = data[1];
+    uint32_t e = data[2];
+    size_t words = 3 + (NUM_LEVELS + 1) + (n + 1) + (size_t)e;
+    if (size != words * sizeof(uint32_t))
+        return false;
+
+    num_nodes = n;
+    num_edges = e;
+    level_begin = data + 3;
+    edge_begin = level_begin + NUM_LEVELS + 1;
+    edges = edge_begin + n + 1;
+    return true;
+}
+
+bool InteriorOracle::save(const string &path) const {
+    if (level_begin == nullptr)
+        return false;
+    ofstream file(path, ios::binary);
+    if (!file)
+        return false;
+    uint32_t header[3] = {ORACLE_MAGIC, num_nodes, num_edges};
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)level_begin, (NUM_LEVELS + 1) * sizeof(uint32_t));
+    file.write((const char *)edge_begin, (num_nodes + 1) * sizeof(uint32_t));
+    file.write((const char *)edges, (size_t)num_edges * sizeof(uint32_t));
+    return (bool)file;
+}
+
+// ファイルをメモリにマップして表として使う
+bool InteriorOracle::load(const string &path) {
+    unmap();
+    storage.clear();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+    mapped = view;
+    mapped_size = size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    mapped = view;
+    mapped_size = st.st_size;
+#endif
+
+    if (!attach((const uint32_t *)mapped, mapped_size)) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void InteriorOracle::unmap() {
+    if (mapped != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapped);
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+#else
+        munmap(mapped, mapped_size);
+#endif
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+    level_begin = edge_begin = edges = nullptr;
+    num_nodes = num_edges = 0;
+}
+
+// ファイルがあれば読み込み、無ければ計算して保存する
+void InteriorOracle::load_or_build(const string &path) {
+    if (load(path))
+        return;
+    cout << "building interior oracle..." << endl;
+    build();
+    if (!save(path))
+        cerr << "error: cannot write " << path << endl;
+}
+
+// 各セルに置けるタイルの集合 domain で展開図が存在するか
+// 内側のセルに制限があるときは通常のDPで判定する
+bool InteriorOracle::has_cp(const array<uint64_t, 49> &domain) {
+    dead_cell = -1;
+
+    bool interior_free = level_begin != nullptr;
+    for (int cell = 0; cell < 25 && interior_free; cell++)
+        interior_free = domain[to_outer_cell(cell)] == ALL_TILES;
+    if (!interior_free) {
+        Counter c(7);
+        c.setTileDomain(domain);
+        bool has = c.hasCP();
+        dead_cell = c.get_dead_cell();
+        return has;
+    }
+
+    // 状態 : (ノード << 20) | mate
+    vector<uint64_t> cur = {(uint64_t)level_begin[0] << MATE_BITS};
+    vector<uint64_t> next;
+    int inner = 0;
+
+    for (int cell = 0; cell < 49; cell++) {
+        next.clear();
+
+        if (is_ring_cell(cell)) {
+            // 外周セルにはタイルを置く
+            for (uint64_t key : cur) {
+                unsigned long long mate = key & MATE_MASK;
+                uint64_t node = key & ~MATE_MASK;
+                for (uint64_t m = domain[cell]; m != 0; m &= m - 1) {
+                    int tile = __builtin_ctzll(m);
+                    if (!counter.can_put(cell, tile, mate))
+                        continue;
+                    next.push_back(node | counter.put(cell, tile, mate));
+                }
+            }
+        } else {
+            // 内側のセルでは表の辺をたどる
+            for (uint64_t key : cur) {
+                unsigned long long mate = key & MATE_MASK;
+                uint32_t node = key >> MATE_BITS;
+                uint32_t edges4 = counter.get_4_edges(cell, mate);
+                for (uint32_t e = edge_begin[node]; e < edge_begin[node + 1];
+                     e++) {
+                    int label = edges[e] & 31;
+                    uint64_t child = edges[e] >> 5;
+                    if ((edges4 & check_mask[inner][label]) !=
+                        check_value[inner][label])
+                        continue;
+                    unsigned long long mate2 =
+                        counter.put_edges(cell, put_edge[inner][label], mate);
+                    next.push_back((child << MATE_BITS) | mate2);
+                }
+            }
+            inner++;
+        }
+
+        sort(next.begin(), next.end());
+        next.erase(unique(next.begin(), next.end()), next.end());
+        cur.swap(next);
+
+        // セル cell で全滅
+        if (cur.empty()) {
+            dead_cell = cell;
+            return false;
+        }
+    }
+    return true;
+}
+
+int InteriorOracle::get_dead_cell() const { return dead_cell; }
+
+uint32_t InteriorOracle::get_num_nodes() const { return num_nodes; }
+
+uint32_t InteriorOracle::get_num_edges() const { return num_edges; }
+
+// 表のファイルの場所（実行ファイルと同じフォルダ）
+string GetOraclePath() { return GetExeDirectory() + "interior_oracle.bin"; }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ftcp.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 7x7 の内側 5x5 のセルにタイルを置けるかを、外周セルとの辺の値だけから判定する表
+//
+// 内側のセルを行優先で1つずつ見ていき、そのセルから外周セルへ延びる辺の値
+// （ラベル、最大5bit）で遷移する層状の決定的なグラフとして持つ
+// 各ノードは、そこまでのラベルの列と矛盾しない内側の mate の集合に対応し、
+// 最後まで到達できないノードは除いて、同じ遷移を持つノードはまとめてある
+// 内側は折り割り当てによらず同じなので、事前に build して save したファイルを
+// load (mmap) して使う
+//
+// 判定は7x7の行優先のDPで、外周セルにはタイルを置き、内側のセルでは
+// 表の辺をたどる。状態は外周セルに関わる mate とノードの組だけになる
+class InteriorOracle {
+    // ファイルの内容（すべて uint32）
+    //   MAGIC, ノード数, 辺の数
+    //   level_begin[26]          : 各層の最初のノード（最後は終端ノード）
+    //   edge_begin[ノード数 + 1] : 各ノードの最初の辺
+    //   edges[辺の数]            : (子ノード << 5) | ラベル
+    const std::uint32_t *level_begin = nullptr;
+    const std::uint32_t *edge_begin = nullptr;
+    const std::uint32_t *edges = nullptr;
+    std::uint32_t num_nodes = 0;
+    std::uint32_t num_edges = 0;
+
+    std::vector<std::uint32_t> storage; // build したときの表の実体
+    void *mapped = nullptr;             // load したときの表の実体
+    std::size_t mapped_size = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+    // 内側のセル（5x5 の番号）のラベルと7x7のmateの照合
+    // check_mask, check_value : 左、左上、上、右上の辺のうち外周セルへの辺とその値
+    // put_edge                : 右、左下、下、右下の外周セルへの辺の値
+    int out_dirs[25][5];
+    int num_out_dirs[25];
+    std::uint32_t check_mask[25][32];
+    std::uint32_t check_value[25][32];
+    int put_edge[25][32][8];
+
+    Counter counter;
+    int dead_cell = -1;
+
+    bool attach(const std::uint32_t *data, std::size_t size);
+    void unmap();
+
+  public:
+    InteriorOracle();
+    ~InteriorOracle();
+    InteriorOracle(const InteriorOracle &) = delete;
+    InteriorOracle &operator=(const InteriorOracle &) = delete;
+
+    void build();
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+    void load_or_build(const std::string &path);
+
+    bool has_cp(const std::array<std::uint64_t, 49> &domain);
+    int get_dead_cell() const;
+    std::uint32_t get_num_nodes() const;
+    std::uint32_t get_num_edges() const;
+};
+
+std::string GetOraclePath();
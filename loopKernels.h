@@ -0,0 +1,86 @@
+#pragma once
+
+// PackedLoop に対する幾何条件の判定
+//
+// 頂点の座標は SoA (xs, ys) に展開してから距離条件の表とまとめて比較し、
+// 曲がり方の条件は曲がり方のワードと縦移動のワードのビット演算で判定する
+// dotToGraph と path_filter で同じものを使う
+
+#include "distanceConstraint.h"
+#include "packedLoop.h"
+
+#include <cstdint>
+
+// ループの頂点座標（SoA）
+struct LoopCoords {
+    int x[PackedLoop::LENGTH];
+    int y[PackedLoop::LENGTH];
+
+    explicit LoopCoords(const PackedLoop &loop) {
+        for (int i = 0; i < PackedLoop::LENGTH; i++) {
+            int n = loop.node(i);
+            x[i] = n % 9;
+            y[i] = n / 9;
+        }
+    }
+};
+
+// 距離条件を満たすズラシの集合（bit j : 先頭を j 歩ずらしたループが条件を満たす）
+inline unsigned int feasible_slides(const PackedLoop &loop) {
+    LoopCoords c(loop);
+    return feasible_slides(c.x, c.y);
+}
+
+// 先頭の頂点をカドに割り当てたときに距離条件を満たすか
+inline bool satisfies_distance(const PackedLoop &loop) {
+    return (feasible_slides(loop) & 1) != 0;
+}
+
+// 右折が左折より4回多い（時計回りに一周する）か
+inline bool turns_clockwise(const PackedLoop &loop) {
+    return loop.right_turns() - loop.left_turns() == 4;
+}
+
+// 十字路で曲がっているか
+// 同じ頂点を、縦の直進（またはUターン）の直後に横の直進で、あるいはその逆で
+// 通ったら false
+inline bool turns_at_crossings(const PackedLoop &loop) {
+    std::uint32_t straight = loop.straights();
+    std::uint32_t vertical = straight & loop.verticals();
+    std::uint32_t horizontal = straight & ~loop.verticals();
+
+    // 縦に直進する頂点と横に直進する頂点の集合（81bit を2ワードで持つ）
+    std::uint64_t v_nodes[2] = {0, 0}, h_nodes[2] = {0, 0};
+    for (std::uint32_t m = vertical; m != 0; m &= m - 1) {
+        int n = loop.node(__builtin_ctz(m));
+        v_nodes[n >> 6] |= 1ULL << (n & 63);
+    }
+    for (std::uint32_t m = horizontal; m != 0; m &= m - 1) {
+        int n = loop.node(__builtin_ctz(m));
+        h_nodes[n >> 6] |= 1ULL << (n & 63);
+    }
+    std::uint64_t both[2] = {v_nodes[0] & h_nodes[0], v_nodes[1] & h_nodes[1]};
+    if ((both[0] | both[1]) == 0)
+        return true;
+
+    // 縦にも横にも直進する頂点があるときだけ、通る順に直前の通り方と比べる
+    // （間に曲がって通ると直前の通り方は消える）
+    int last[81];
+    for (int i = 0; i < PackedLoop::LENGTH; i++) {
+        int n = loop.node(i);
+        if (((both[n >> 6] >> (n & 63)) & 1) == 0)
+            continue;
+        last[n] = 0;
+    }
+    for (int i = 0; i < PackedLoop::LENGTH; i++) {
+        int n = loop.node(i);
+        if (((both[n >> 6] >> (n & 63)) & 1) == 0)
+            continue;
+        // 0 : 曲がった、1 : 縦に直進、2 : 横に直進
+        int d = ((vertical >> i) & 1) ? 1 : ((horizontal >> i) & 1) ? 2 : 0;
+        if (last[n] != 0 && d != 0 && last[n] != d)
+            return false;
+        last[n] = d;
+    }
+    return true;
+}
@@ -0,0 +1,365 @@
+#include "loopSolver.h"
+#include "tileDomain.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <unordered_map>
+
+using namespace std;
+
+#define FRONT 1
+#define BACK 0
+
+// 状態の配置
+// bit  0-19 : mate
+// bit 20,21 : 列ごとの表裏
+// bit 22-36 : 列0で直近に決めた折り方（3bitずつ、新しいものが下位）
+// bit 37-51 : 列1で直近に決めた折り方
+const int MATE_BITS = 20;
+const uint64_t MATE_MASK = (1ULL << MATE_BITS) - 1;
+const int SIDE_SHIFT[2] = {20, 21};
+const int WIN_SHIFT[2] = {22, 37};
+const uint64_t WIN_MASK = (1ULL << 15) - 1;
+
+// 状態に持つ折り方の番号（カドの8も含む）
+const int VALUE_OF_CODE[6] = {0, 1, 3, 4, 6, 8};
+const int CODE_OF_VALUE[9] = {0, 1, -1, 2, 3, -1, 4, -1, 5};
+const int FLIP[9] = {0, 1, 0, 0, 1, 0, 0, 0, 0};
+
+// 向きと折り番号の対応（LRtoNum2 の fold_table と同じ）
+static bool can_fold(int side, int dir, int f) {
+    if (dir == 0)
+        return f == 0;
+    bool mountain = (side == FRONT) == (dir == 1);
+    if (mountain)
+        return f == 1 || f == 3 || f == 6;
+    return f == 4;
+}
+
+// カドを挟む (left, 8, right) が折れない組み合わせか
+static bool is_ng_corner_triple(int left, int right) {
+    if (left == 0 || left == 4 || left == 6)
+        return right == 4 || right == 6;
+    if (left == 1 || left == 3)
+        return right == 0 || right == 1 || right == 3;
+    return false;
+}
+
+LoopSolver::LoopSolver() : counter(7) {
+    // 列0 : 0,1,...,16  列1 : 31,30,...,17
+    for (int out = 0; out <= 16; out++)
+        chains[0].push_back(out);
+    for (int out = 31; out >= 17; out--)
+        chains[1].push_back(out);
+
+    for (int c = 0; c < 2; c++) {
+        for (int k = 0; k < (int)chains[c].size(); k++) {
+            chain_of[chains[c][k]] = c;
+            index_of[chains[c][k]] = k;
+        }
+    }
+
+    // 外周頂点が制限をかけるセルの最小値と最大値
+    int first_cell[32], last_cell[32];
+    for (int out = 0; out < 32; out++) {
+        first_cell[out] = 49;
+        last_cell[out] = -1;
+        for (int j = 0; j < 3; j++) {
+            int cell = FOLD_TILE_MASK.cell[out][j];
+            if (cell == -1)
+                continue;
+            first_cell[out] = min(first_cell[out], cell);
+            last_cell[out] = max(last_cell[out], cell);
+        }
+    }
+
+    // 折り方を決めるセル
+    // カドは列の次の外周頂点と同時に決める（列の最後のカドは直前の外周頂点と同時）
+    for (int c = 0; c < 2; c++) {
+        int n = chains[c].size();
+        vector<int> cells(n);
+        for (int k = n - 1; k >= 0; k--) {
+            int out = chains[c][k];
+            if (out % 8 != 0)
+                cells[k] = first_cell[out];
+            else if (k + 1 < n)
+                cells[k] = cells[k + 1];
+            else
+                cells[k] = -1;
+        }
+        if (cells[n - 1] == -1)
+            cells[n - 1] = cells[n - 2];
+
+        for (int k = 0; k < n; k++) {
+            assert(k == 0 || cells[k - 1] <= cells[k]);
+            decide[cells[k]].push_back(chains[c][k]);
+        }
+    }
+
+    junction_cell = 0;
+    for (int cell = 0; cell < 49; cell++) {
+        for (int c = 0; c < 2; c++) {
+            decided[cell][c] = cell == 0 ? 0 : decided[cell - 1][c];
+            for (int out : decide[cell])
+                decided[cell][c] += chain_of[out] == c;
+        }
+        if (!decide[cell].empty())
+            junction_cell = cell;
+    }
+
+    // タイルを制限する外周頂点の状態中の位置
+    for (int out = 0; out < 32; out++) {
+        for (int j = 0; j < 3; j++) {
+            int cell = FOLD_TILE_MASK.cell[out][j];
+            if (cell == -1)
+                continue;
+            int c = chain_of[out];
+            int slot = decided[cell][c] - 1 - index_of[out];
+            assert(0 <= slot && slot < WINDOW);
+            refs[cell].push_back({c, slot, out, j});
+        }
+    }
+
+    // セルを置いた後に状態に残す部分
+    // 以降のセルを制限する折り方と、2本の列がつながるまでの表裏と直近2つの折り方
+    for (int cell = 0; cell < 49; cell++) {
+        uint64_t mask = MATE_MASK;
+        for (int c = 0; c < 2; c++) {
+            if (cell < junction_cell)
+                mask |= 1ULL << SIDE_SHIFT[c];
+            for (int slot = 0; slot < WINDOW; slot++) {
+                int k = decided[cell][c] - 1 - slot;
+                if (k < 0)
+                    continue;
+                bool keep = last_cell[chains[c][k]] > cell ||
+                            (cell < junction_cell && slot < 2);
+                if (keep)
+                    mask |= 7ULL << (WIN_SHIFT[c] + 3 * slot);
+            }
+        }
+        keep_mask[cell] = mask;
+    }
+
+    witness.fill(0);
+}
+
+// 外周頂点 out の折り方を f にしたときの状態
+// 折り方の生成規則に反する場合は false
+bool LoopSolver::decide_fold(int out, uint64_t key, int f,
+                             uint64_t &next) const {
+    int c = chain_of[out];
+    int k = index_of[out];
+    int side = (key >> SIDE_SHIFT[c]) & 1;
+    uint64_t win = (key >> WIN_SHIFT[c]) & WIN_MASK;
+    int last = k >= 1 ? VALUE_OF_CODE[win & 7] : -1;
+    int prev = k >= 2 ? VALUE_OF_CODE[(win >> 3) & 7] : -1;
+    int dir = dirs[out];
+
+    int new_side;
+    if (out % 8 == 0) {
+        // 8の倍数の処理
+        if (f != 8)
+            return false;
+        if (side == BACK && dir == 1)
+            return false;
+        if (side == FRONT && dir == -1)
+            return false;
+        new_side = side;
+    } else {
+        if (f == 8)
+            return false;
+
+        // 列1は後ろから決めるので、表裏は折った後の状態から逆算する
+        int s = c == 0 ? side : side ^ FLIP[f];
+        if (!can_fold(s, dir, f))
+            return false;
+        new_side = c == 0 ? side ^ FLIP[f] : s;
+
+        // NGワード "34", "36", "x8y" (元の並び順で判定する)
+        int left = c == 0 ? last : f;
+        int right = c == 0 ? f : last;
+        if (left == 3 && (right == 4 || right == 6))
+            return false;
+        if (last == 8 && prev != -1) {
+            int l = c == 0 ? prev : f;
+            int r = c == 0 ? f : prev;
+            if (is_ng_corner_triple(l, r))
+                return false;
+        }
+    }
+
+    win = ((win << 3) | CODE_OF_VALUE[f]) & WIN_MASK;
+    next = key;
+    next &= ~(1ULL << SIDE_SHIFT[c]);
+    next |= (uint64_t)new_side << SIDE_SHIFT[c];
+    next &= ~(WIN_MASK << WIN_SHIFT[c]);
+    next |= win << WIN_SHIFT[c];
+    return true;
+}
+
+// セル cell の前に決める外周頂点の折り方をすべて試す
+// out には決めた後の状態と、決めた折り方（3bitずつ）の組を入れる
+void LoopSolver::expand(int cell, uint64_t key,
+                        vector<pair<uint64_t, uint64_t>> &out) const {
+    out.clear();
+    out.push_back({key, 0});
+    for (int i = 0; i < (int)decide[cell].size(); i++) {
+        int o = decide[cell][i];
+        vector<pair<uint64_t, uint64_t>> next;
+        for (auto [k, choices] : out) {
+            for (int code = 0; code < 6; code++) {
+                uint64_t nk;
+                if (!decide_fold(o, k, VALUE_OF_CODE[code], nk))
+                    continue;
+                next.push_back({nk, choices | (uint64_t)code << (3 * i)});
+            }
+        }
+        out.swap(next);
+    }
+}
+
+// 頂点16で2本の列がつながるか
+// 列0の最後は (15, 16)、列1の最後は 17
+bool LoopSolver::check_junction(uint64_t key) const {
+    if (((key >> SIDE_SHIFT[0]) & 1) != ((key >> SIDE_SHIFT[1]) & 1))
+        return false;
+    int f15 = VALUE_OF_CODE[(key >> (WIN_SHIFT[0] + 3)) & 7];
+    int f17 = VALUE_OF_CODE[(key >> WIN_SHIFT[1]) & 7];
+    return !is_ng_corner_triple(f15, f17);
+}
+
+// 状態に含まれる折り方から、セルに置けるタイルの集合を求める
+uint64_t LoopSolver::get_domain(int cell, uint64_t key) const {
+    uint64_t domain = BASE_TILE_DOMAIN[cell];
+    for (const Ref &r : refs[cell]) {
+        int code = (key >> (WIN_SHIFT[r.chain] + 3 * r.slot)) & 7;
+        domain &= FOLD_TILE_MASK.mask[r.out][VALUE_OF_CODE[code]][r.j];
+    }
+    return domain;
+}
+
+// セル cell にタイルを置いた後の状態と、置いたタイルをすべて求める
+void LoopSolver::place(int cell, uint64_t key, vector<uint64_t> &out,
+                       vector<int> &tiles) {
+    out.clear();
+    tiles.clear();
+    unsigned long long mate = key & MATE_MASK;
+    for (uint64_t m = get_domain(cell, key); m != 0; m &= m - 1) {
+        int tile = __builtin_ctzll(m);
+        if (!counter.can_put(cell, tile, mate))
+            continue;
+        uint64_t next = (key & ~MATE_MASK) | counter.put(cell, tile, mate);
+        out.push_back(next & keep_mask[cell]);
+        tiles.push_back(tile);
+    }
+}
+
+// ループから生成される折り割り当てのうち平坦折り可能なものがあるか
+bool LoopSolver::solve(const string &loopstr) {
+    layers.clear();
+    parents.clear();
+    max_states = 0;
+    total_states = 0;
+
+    // 8の倍数番目の文字がSなら不適
+    if (loopstr.size() != 32)
+        return false;
+    if (loopstr[0] == 'S' || loopstr[8] == 'S' || loopstr[16] == 'S' ||
+        loopstr[24] == 'S')
+        return false;
+
+    for (int out = 0; out < 32; out++) {
+        char ch = loopstr[out];
+        dirs[out] = ch == 'R' ? 1 : (ch == 'L' ? -1 : 0);
+    }
+
+    // 列0は頂点0の向きから表裏が決まる
+    // 列1は最後の頂点を折った後の表裏が分からないので両方試す
+    uint64_t side0 = loopstr[0] == 'R' ? FRONT : BACK;
+    layers.push_back({side0 << SIDE_SHIFT[0],
+                      side0 << SIDE_SHIFT[0] | 1ULL << SIDE_SHIFT[1]});
+    parents.push_back({0, 0});
+
+    vector<pair<uint64_t, uint64_t>> expanded;
+    vector<uint64_t> placed;
+    vector<int> tiles;
+    for (int cell = 0; cell < 49; cell++) {
+        const vector<uint64_t> &prev = layers.back();
+        vector<uint64_t> keys;
+        vector<uint32_t> from;
+        unordered_map<uint64_t, uint32_t> index;
+
+        for (uint32_t i = 0; i < prev.size(); i++) {
+            expand(cell, prev[i], expanded);
+            for (auto [k, choices] : expanded) {
+                if (cell == junction_cell && !check_junction(k))
+                    continue;
+                place(cell, k, placed, tiles);
+                for (uint64_t next : placed) {
+                    if (!index.emplace(next, keys.size()).second)
+                        continue;
+                    keys.push_back(next);
+                    from.push_back(i);
+                }
+            }
+        }
+
+        max_states = max(max_states, (unsigned long long)keys.size());
+        total_states += keys.size();
+        layers.push_back(move(keys));
+        parents.push_back(move(from));
+
+        // セル cell で全滅
+        if (layers.back().empty())
+            return false;
+    }
+
+    restore_witness(0);
+    return true;
+}
+
+// 最後のセルの状態 index から、そこに至る折り割り当てとタイルを復元する
+void LoopSolver::restore_witness(uint32_t index) {
+    witness.fill(0);
+    witness_tiles.fill(0);
+    vector<pair<uint64_t, uint64_t>> expanded;
+    vector<uint64_t> placed;
+    vector<int> tiles;
+
+    for (int cell = 48; cell >= 0; cell--) {
+        uint64_t key = layers[cell + 1][index];
+        uint32_t parent = parents[cell + 1][index];
+
+        // 親の状態から key に至る折り方の選び方を探す
+        bool found = false;
+        expand(cell, layers[cell][parent], expanded);
+        for (auto [k, choices] : expanded) {
+            if (cell == junction_cell && !check_junction(k))
+                continue;
+            place(cell, k, placed, tiles);
+            auto it = find(placed.begin(), placed.end(), key);
+            if (it == placed.end())
+                continue;
+            witness_tiles[cell] = tiles[it - placed.begin()];
+            for (int i = 0; i < (int)decide[cell].size(); i++)
+                witness[decide[cell][i]] = VALUE_OF_CODE[(choices >> 3 * i) & 7];
+            found = true;
+            break;
+        }
+        assert(found);
+        index = parent;
+    }
+}
+
+array<int, 32> LoopSolver::get_folds() const { return witness; }
+
+// 見つけた展開図（Counter::findCP と同じ形式）
+string LoopSolver::get_cpstr() const {
+    string cpstr;
+    for (int cell = 0; cell < 49; cell++) {
+        int tile = witness_tiles[cell];
+        cpstr += (tile < 10 ? "0" : "") + to_string(tile);
+    }
+    return cpstr;
+}
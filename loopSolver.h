@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ftcp.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ループ（SRL からなる32文字）から LRtoNum2 が生成するすべての折り割り当てについて、
+// 平坦折り可能なものが存在するかを1回のDPで判定する
+//
+// 折り割り当てを外で列挙する代わりに、折り方の生成規則（表裏の状態、
+// {1,3,6} と {4} の選択、NGワード）をタイル敷き詰めのDPの状態に含める
+// 外周頂点は 0,1,...,16 と 31,30,...,17 の2本の列に分け、
+// DPが必要とする順に折り方を決める
+// 各列で直近に決めた WINDOW 個の折り方と表裏だけを状態に持ち、
+// 2本の列は頂点16で表裏とカドの条件が一致するか確かめる
+class LoopSolver {
+    static const int WINDOW = 5;
+
+    // セル cell のタイルを制限する外周頂点が、状態のどこにあるか
+    struct Ref {
+        int chain;
+        int slot;
+        int out;
+        int j;
+    };
+
+    std::vector<int> chains[2];       // 列ごとの外周頂点の順番
+    int chain_of[32];                 // 外周頂点の属する列
+    int index_of[32];                 // 外周頂点の列の中での番号
+    std::vector<int> decide[49];      // セルに置く前に折り方を決める外周頂点
+    int decided[49][2];               // セルまでに決めた外周頂点の数
+    std::vector<Ref> refs[49];        // セルのタイルを制限する外周頂点
+    std::uint64_t keep_mask[49];      // セルを置いた後も状態に残す部分
+    int junction_cell;                // 2本の列がつながるセル
+
+    int dirs[32];
+    Counter counter;
+
+    // 各セルを置いた後の状態と、1つ前のセルでの状態の番号
+    std::vector<std::vector<std::uint64_t>> layers;
+    std::vector<std::vector<std::uint32_t>> parents;
+
+    std::array<int, 32> witness;
+    std::array<int, 49> witness_tiles;
+
+    void expand(int cell, std::uint64_t key,
+                std::vector<std::pair<std::uint64_t, std::uint64_t>> &out)
+        const;
+    bool decide_fold(int out, std::uint64_t key, int f,
+                     std::uint64_t &next) const;
+    bool check_junction(std::uint64_t key) const;
+    std::uint64_t get_domain(int cell, std::uint64_t key) const;
+    void place(int cell, std::uint64_t key, std::vector<std::uint64_t> &out,
+               std::vector<int> &tiles);
+    void restore_witness(std::uint32_t index);
+
+  public:
+    unsigned long long max_states = 0;
+    unsigned long long total_states = 0;
+
+    LoopSolver();
+    bool solve(const std::string &loopstr);
+    std::array<int, 32> get_folds() const;
+    std::string get_cpstr() const;
+};
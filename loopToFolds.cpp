@@ -449,6 +449,35 @@ vector<vector<int>> createAllFolds(string input_str)
     return all_folds;
 }
 
+// ループ（SRL からなる32文字）がカドと斜め線の本数の条件を満たさないか
+bool is_NG_loopstr(string loopstr)
+{
+    // カドの配置について
+    if (loopstr[0] == 'S')
+        return true;
+    if (loopstr[8] == 'S')
+        return true;
+    if (loopstr[16] == 'S')
+        return true;
+    if (loopstr[24] == 'S')
+        return true;
+
+    // 偶頂点から出る斜め線の本数は偶数でなければならない
+    // 奇頂点から出る斜め線の本数は偶数でなければならない
+    int count[2] = {0, 0};
+    for (int i = 0; i < 32; i++)
+    {
+        if (i % 8 == 0)
+            continue;
+        char c = loopstr[i];
+        if (c != 'S')
+            count[i % 2]++;
+    }
+    if (count[0] % 2 != 0 || count[1] % 2 != 0)
+        return true;
+    return false;
+}
+
 #if 0
 int main(void)
 {
@@ -493,4 +522,4 @@ int main(void)
 
     return 0;
 }
-#endif
\ No newline at end of file
+#endif
@@ -9,3 +9,4 @@
 #define X 2
 
 std::vector<std::vector<int>> createAllFolds(std::string input_str);
+bool is_NG_loopstr(std::string loopstr);
@@ -0,0 +1,200 @@
+#pragma once
+
+// 外周32歩のループを詰めて持つ値型
+//
+// 頂点は y * 9 + x の番号（path_filter / solve_non_connect と同じ）を7bitずつ、
+// 224bit の環として4ワードに詰める
+// 各頂点での曲がり方は2bitずつ64bitのワードに詰める
+//   0 : 直進、1 : 右折、2 : 左折、3 : Uターン（文字列では直進 'S' と同じ扱い）
+// 頂点 i から i + 1 への移動が縦向きかどうかを32bitのワードに詰める
+// 右折・左折は (prev -> curr) と (curr -> next) の外積の符号で決める
+// （BoundaryGraph::getPathDirections と同じ）
+//
+// 先頭をずらす rotated は環のシフトなので、頂点列をコピーし直す必要がない
+// 比較とハッシュはワード単位で行う
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PackedLoop {
+  public:
+    static const int LENGTH = 32;
+    static const int NODE_BITS = 7;
+    static const int RING_BITS = LENGTH * NODE_BITS;
+
+    static const int STRAIGHT = 0;
+    static const int RIGHT = 1;
+    static const int LEFT = 2;
+    static const int U_TURN = 3;
+
+  private:
+    std::array<std::uint64_t, 4> ring = {0, 0, 0, 0};
+    std::uint64_t turn_word = 0;
+    std::uint32_t vertical_word = 0;
+
+    static std::uint64_t get_bits(const std::array<std::uint64_t, 4> &a,
+                                  int bit) {
+        int w = bit >> 6, off = bit & 63;
+        std::uint64_t v = a[w] >> off;
+        if (off + NODE_BITS > 64)
+            v |= a[w + 1] << (64 - off);
+        return v & ((1u << NODE_BITS) - 1);
+    }
+
+    // 224bit の値を s bit だけ右 (s > 0) / 左 (s < 0) にシフトする
+    static std::array<std::uint64_t, 4>
+    shift(const std::array<std::uint64_t, 4> &a, int s) {
+        std::array<std::uint64_t, 4> r = {0, 0, 0, 0};
+        if (s >= 0) {
+            int ws = s >> 6, bs = s & 63;
+            for (int i = 0; i + ws < 4; i++) {
+                r[i] = a[i + ws] >> bs;
+                if (bs != 0 && i + ws + 1 < 4)
+                    r[i] |= a[i + ws + 1] << (64 - bs);
+            }
+        } else {
+            s = -s;
+            int ws = s >> 6, bs = s & 63;
+            for (int i = 3; i - ws >= 0; i--) {
+                r[i] = a[i - ws] << bs;
+                if (bs != 0 && i - ws - 1 >= 0)
+                    r[i] |= a[i - ws - 1] >> (64 - bs);
+            }
+        }
+        r[3] &= (1ULL << (RING_BITS - 192)) - 1;
+        return r;
+    }
+
+    static int get_turn(int prev, int curr, int next) {
+        int dx1 = curr % 9 - prev % 9;
+        int dy1 = curr / 9 - prev / 9;
+        int dx2 = next % 9 - curr % 9;
+        int dy2 = next / 9 - curr / 9;
+        int cp = dx1 * dy2 - dy1 * dx2;
+        if (cp > 0)
+            return RIGHT;
+        if (cp < 0)
+            return LEFT;
+        if (dx1 * dx2 + dy1 * dy2 < 0)
+            return U_TURN;
+        return STRAIGHT;
+    }
+
+  public:
+    // 頂点番号の列をループにする。末尾が先頭と同じ頂点（閉じた形）でもよい
+    // 32歩のループでなければ false を返す
+    static bool pack(const std::vector<int> &nodes, PackedLoop &loop) {
+        int n = nodes.size();
+        if (n == LENGTH + 1 && nodes.front() == nodes.back())
+            n = LENGTH;
+        if (n != LENGTH)
+            return false;
+
+        loop.ring = {0, 0, 0, 0};
+        for (int i = 0; i < LENGTH; i++) {
+            if (nodes[i] < 0 || nodes[i] >= 81)
+                return false;
+            int bit = i * NODE_BITS;
+            std::uint64_t v = nodes[i];
+            loop.ring[bit >> 6] |= v << (bit & 63);
+            if ((bit & 63) + NODE_BITS > 64)
+                loop.ring[(bit >> 6) + 1] |= v >> (64 - (bit & 63));
+        }
+
+        loop.turn_word = 0;
+        loop.vertical_word = 0;
+        for (int i = 0; i < LENGTH; i++) {
+            int next = nodes[(i + 1) % LENGTH];
+            int t = get_turn(nodes[(i + LENGTH - 1) % LENGTH], nodes[i], next);
+            loop.turn_word |= (std::uint64_t)t << (2 * i);
+            if (nodes[i] % 9 == next % 9)
+                loop.vertical_word |= 1u << i;
+        }
+        return true;
+    }
+
+    int node(int i) const { return get_bits(ring, i * NODE_BITS); }
+    int x(int i) const { return node(i) % 9; }
+    int y(int i) const { return node(i) / 9; }
+    int turn(int i) const { return (turn_word >> (2 * i)) & 3; }
+    std::uint64_t turns() const { return turn_word; }
+    std::uint32_t verticals() const { return vertical_word; }
+
+    // 直進またはUターンする位置の集合（bit i が位置 i）
+    std::uint32_t straights() const {
+        // 2bit の上位と下位が等しい (0 か 3) 位置を取り出して32bitに詰める
+        std::uint64_t same = ~(turn_word ^ (turn_word >> 1)) &
+                             0x5555555555555555ULL;
+        std::uint32_t r = 0;
+        for (std::uint64_t m = same; m != 0; m &= m - 1)
+            r |= 1u << (__builtin_ctzll(m) >> 1);
+        return r;
+    }
+
+    // 右折・左折の数
+    int right_turns() const {
+        return __builtin_popcountll(turn_word & ~(turn_word >> 1) &
+                                    0x5555555555555555ULL);
+    }
+    int left_turns() const {
+        return __builtin_popcountll((turn_word >> 1) & ~turn_word &
+                                    0x5555555555555555ULL);
+    }
+
+    // 先頭を k 歩ずらしたループ（新しい i 番目は元の (i + k) % 32 番目）
+    PackedLoop rotated(int k) const {
+        k = ((k % LENGTH) + LENGTH) % LENGTH;
+        if (k == 0)
+            return *this;
+        PackedLoop r;
+        int s = k * NODE_BITS;
+        std::array<std::uint64_t, 4> lo = shift(ring, s);
+        std::array<std::uint64_t, 4> hi = shift(ring, -(RING_BITS - s));
+        for (int i = 0; i < 4; i++)
+            r.ring[i] = lo[i] | hi[i];
+        r.turn_word = (turn_word >> (2 * k)) | (turn_word << (64 - 2 * k));
+        r.vertical_word =
+            (vertical_word >> k) | (vertical_word << (LENGTH - k));
+        return r;
+    }
+
+    // "RLS..." の形の32文字
+    std::string turn_string() const {
+        static const char TURN_CHAR[4] = {'S', 'R', 'L', 'S'};
+        std::string s(LENGTH, 'S');
+        for (int i = 0; i < LENGTH; i++)
+            s[i] = TURN_CHAR[turn(i)];
+        return s;
+    }
+
+    std::vector<int> nodes() const {
+        std::vector<int> v(LENGTH);
+        for (int i = 0; i < LENGTH; i++)
+            v[i] = node(i);
+        return v;
+    }
+
+    bool operator==(const PackedLoop &o) const {
+        return ring == o.ring && turn_word == o.turn_word;
+    }
+    bool operator!=(const PackedLoop &o) const { return !(*this == o); }
+    bool operator<(const PackedLoop &o) const {
+        if (ring != o.ring)
+            return ring < o.ring;
+        return turn_word < o.turn_word;
+    }
+
+    std::size_t hash() const {
+        std::uint64_t h = turn_word;
+        for (int i = 0; i < 4; i++)
+            h ^= ring[i] + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return (std::size_t)h;
+    }
+};
+
+struct PackedLoopHash {
+    std::size_t operator()(const PackedLoop &l) const { return l.hash(); }
+};
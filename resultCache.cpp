@@ -0,0 +1,469 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "resultCache.h"
+#include "ftcp.h"
+#include "tileDomain.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+const uint32_t CACHE_MAGIC = 0x32435252; // "RRC2"
+const uint32_t INITIAL_CAPACITY = 1024;
+const size_t HEADER_BYTES = 16;
+
+static_assert(HEADER_BYTES % alignof(ResultCache::Slot) == 0,
+              "slots must stay aligned after the header");
+
+static size_t file_bytes(uint32_t capacity) {
+    return HEADER_BYTES + (size_t)capacity * sizeof(ResultCache::Slot);
+}
+
+ResultCache::ResultCache(const string &path) : path(path) {}
+
+ResultCache::~ResultCache() { unmap(); }
+
+// ファイルを capacity 個の項目の大きさにして、読み書きできるようにマップする
+// 中身はそのまま（広げた部分は0）なので、初期化は呼び出し側で行う
+bool ResultCache::map(uint32_t capacity) {
+    unmap();
+    size_t size = file_bytes(capacity);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    // マップする大きさまでファイルは自動的に広がる
+    HANDLE mapping =
+        CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                           (DWORD)((unsigned long long)size >> 32),
+                           (DWORD)(size & 0xffffffffULL), NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+#else
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+        return false;
+    if (ftruncate(fd, size) == -1) {
+        close(fd);
+        return false;
+    }
+    void *view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+#endif
+
+    mapped = view;
+    mapped_size = size;
+    header = (uint32_t *)mapped;
+    slots = (Slot *)((char *)mapped + HEADER_BYTES);
+    return true;
+}
+
+void ResultCache::unmap() {
+    if (mapped != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapped);
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+#else
+        munmap(mapped, mapped_size);
+#endif
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+    header = nullptr;
+    slots = nullptr;
+}
+
+// 最初に呼ばれたときにファイルを開く。壊れていれば空の表で作り直す
+bool ResultCache::ensure_open() {
+    if (opened)
+        return mapped != nullptr;
+    opened = true;
+
+    uint32_t saved[2] = {0, 0};
+    size_t size = 0;
+    {
+        ifstream file(path, ios::binary | ios::ate);
+        if (file) {
+            size = file.tellg();
+            file.seekg(0);
+            file.read((char *)saved, sizeof(saved));
+        }
+    }
+    if (size >= HEADER_BYTES && saved[0] == CACHE_MAGIC && saved[1] != 0 &&
+        size == file_bytes(saved[1]))
+        return map(saved[1]);
+
+    if (!map(INITIAL_CAPACITY)) {
+        cerr << "error: cannot open " << path << endl;
+        return false;
+    }
+    memset(mapped, 0, mapped_size);
+    header[0] = CACHE_MAGIC;
+    header[1] = INITIAL_CAPACITY;
+    return true;
+}
+
+// 容量を2倍にして、使っている項目を入れ直す
+bool ResultCache::grow() {
+    uint32_t capacity = header[1];
+    vector<Slot> used;
+    for (uint32_t i = 0; i < capacity; i++)
+        if (slots[i].key != 0)
+            used.push_back(slots[i]);
+
+    if (!map(capacity * 2))
+        return false;
+    memset(mapped, 0, mapped_size);
+    header[0] = CACHE_MAGIC;
+    header[1] = capacity * 2;
+    header[2] = used.size();
+    for (const Slot &s : used)
+        *probe(s.key) = s;
+    return true;
+}
+
+// key の項目か、key を入れるべき空きの項目（線形探索）
+ResultCache::Slot *ResultCache::probe(uint64_t key) const {
+    uint32_t capacity = header[1];
+    uint32_t i = (key * 0x9e3779b97f4a7c15ULL) >> 32;
+    for (i %= capacity;; i = (i + 1) % capacity)
+        if (slots[i].key == key || slots[i].key == 0)
+            return &slots[i];
+}
+
+ResultCache::Slot *ResultCache::find(uint64_t key) {
+    if (key == 0 || !ensure_open())
+        return nullptr;
+    Slot *s = probe(key);
+    return s->key == key ? s : nullptr;
+}
+
+ResultCache::Slot *ResultCache::insert(uint64_t key) {
+    if (key == 0 || !ensure_open())
+        return nullptr;
+    Slot *s = probe(key);
+    if (s->key == key)
+        return s;
+
+    // 使っている項目を容量の3/4までに抑える
+    if ((header[2] + 1) * 4 > header[1] * 3) {
+        if (!grow()) {
+            cerr << "error: cannot grow " << path << endl;
+            return nullptr;
+        }
+        s = probe(key);
+    }
+    memset(s, 0, sizeof(Slot));
+    s->key = key;
+    s->state = SEARCHING;
+    s->num_cycles = CYCLES_NOT_STORED;
+    header[2]++;
+    return s;
+}
+
+uint64_t ResultCache::canonical_key(const vector<vector<int>> &grid, int &t) {
+    uint64_t best = ~0ULL;
+    for (int u = 0; u < 8; u++) {
+        uint64_t key = 0;
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                if (grid[y][x] == 0)
+                    continue;
+                // u & 1 : 左右反転、u & 2 : 上下反転、u & 4 : 転置
+                int tx = u & 1 ? 7 - x : x;
+                int ty = u & 2 ? 7 - y : y;
+                if (u & 4)
+                    swap(tx, ty);
+                key |= 1ULL << (ty * 8 + tx);
+            }
+        }
+        if (key < best) {
+            best = key;
+            t = u;
+        }
+    }
+    return best;
+}
+
+// 格子点 v = y * 9 + x を、ドット絵の回転・反転 t（inverse なら逆変換）で移す
+static int map_node(int v, int t, bool inverse) {
+    int x = v % 9, y = v / 9;
+    if (inverse && (t & 4))
+        swap(x, y);
+    if (t & 1)
+        x = 8 - x;
+    if (t & 2)
+        y = 8 - y;
+    if (!inverse && (t & 4))
+        swap(x, y);
+    return y * 9 + x;
+}
+
+// 反転を奇数回含むか（ループの向きが逆になる）
+static bool is_mirror(int t) { return __builtin_popcount(t) % 2 != 0; }
+
+// 時計回りのループ nodes を t で移し、先頭を最も左（その中で最も上）の頂点にする
+// ずらし slide の展開図が、移したループのどのずらしのどの展開図になるかも返す
+//
+// 反転のないときは、元の位置 p が p - p0 に移る（p0 は新しい先頭の元の位置）
+// 外周頂点 i は位置 slide + i から s + i（s = slide - p0）に対応するので、
+// ずらしは s mod 8 で、展開図は外周を 8 * (s / 8) だけ回す（時計回りに s / 8 回）
+// 反転のあるときはループを逆にたどるので位置 p は p0 - p に移り、
+// 展開図を左右反転すると外周頂点 i は 8 - i になるので、s = p0 - (slide + 8)
+void ResultCache::map_loop(const int *nodes, int slide, int t, bool inverse,
+                           int *mapped, int &mapped_slide,
+                           Placement &placement) {
+    const int n = PackedLoop::LENGTH;
+    bool mirror = is_mirror(t);
+    int moved[PackedLoop::LENGTH];
+    int p0 = 0;
+    for (int p = 0; p < n; p++) {
+        moved[p] = map_node(nodes[p], t, inverse);
+        int x = moved[p] % 9, y = moved[p] / 9;
+        int bx = moved[p0] % 9, by = moved[p0] / 9;
+        if (x < bx || (x == bx && y < by))
+            p0 = p;
+    }
+    for (int i = 0; i < n; i++)
+        mapped[i] = moved[(mirror ? p0 - i + n : p0 + i) % n];
+
+    int s = mirror ? p0 - slide - 8 : slide - p0;
+    s = ((s % n) + n) % n;
+    mapped_slide = s % 8;
+    placement.mirror = mirror;
+    placement.quarter = s / 8;
+}
+
+// 方向 d の辺の有無を並べた8bitからタイル番号への表（無い組み合わせは -1）
+static array<int, 256> make_tile_index() {
+    array<int, 256> index;
+    index.fill(-1);
+    for (int tile = 0; tile < 36; tile++) {
+        int bits = 0;
+        for (int d = 0; d < 8; d++)
+            bits |= TILE[tile][d] << d;
+        index[bits] = tile;
+    }
+    return index;
+}
+
+// タイルの辺の方向を d -> dir[d] に移す
+static int map_tile(int tile, const int *dir) {
+    static const array<int, 256> index = make_tile_index();
+    int bits = 0;
+    for (int d = 0; d < 8; d++)
+        bits |= TILE[tile][d] << dir[d];
+    return index[bits];
+}
+
+void ResultCache::place(const Placement &placement, array<int, 32> &folds,
+                        array<int, 49> &tiles, array<int, 4> &corners) {
+    // 左右反転 (x, y) -> (8 - x, y)
+    // 外周頂点 i は 8 - i に、折りの辺 0 と 2 は入れ替わり、左上と右上、
+    // 右下と左下のカドが入れ替わる
+    if (placement.mirror) {
+        static const int dir[8] = {0, 7, 6, 5, 4, 3, 2, 1};
+        array<int, 32> f;
+        array<int, 49> tl;
+        array<int, 4> c;
+        for (int i = 0; i < 32; i++) {
+            int v = folds[i];
+            f[(40 - i) % 32] = (v & 2) | (v >> 2 & 1) | (v & 1) << 2;
+        }
+        for (int cell = 0; cell < 49; cell++)
+            tl[cell / 7 * 7 + 6 - cell % 7] = map_tile(tiles[cell], dir);
+        for (int k = 0; k < 4; k++)
+            c[(5 - k) % 4] = corners[k];
+        folds = f;
+        tiles = tl;
+        corners = c;
+    }
+
+    // 時計回りに90度 (x, y) -> (8 - y, x)
+    // 外周頂点 i は i + 8 に、カド k は k + 1 に移る
+    for (int q = 0; q < placement.quarter; q++) {
+        static const int dir[8] = {2, 3, 4, 5, 6, 7, 0, 1};
+        array<int, 32> f;
+        array<int, 49> tl;
+        array<int, 4> c;
+        for (int i = 0; i < 32; i++)
+            f[(i + 8) % 32] = folds[i];
+        for (int cell = 0; cell < 49; cell++) {
+            int x = cell % 7, y = cell / 7;
+            tl[x * 7 + 6 - y] = map_tile(tiles[cell], dir);
+        }
+        for (int k = 0; k < 4; k++)
+            c[(k + 1) % 4] = corners[k];
+        folds = f;
+        tiles = tl;
+        corners = c;
+    }
+}
+
+static void get_nodes(const PackedLoop &loop, int *nodes) {
+    for (int i = 0; i < PackedLoop::LENGTH; i++)
+        nodes[i] = loop.node(i);
+}
+
+static PackedLoop to_loop(const int *nodes) {
+    vector<int> v(nodes, nodes + PackedLoop::LENGTH);
+    PackedLoop loop;
+    PackedLoop::pack(v, loop);
+    return loop;
+}
+
+// ループが多すぎれば保存しない（ずらしの結果も保存しない）
+void ResultCache::store_cycles(Slot &slot, const vector<PackedLoop> &cycles,
+                               int t) {
+    if (cycles.size() > MAX_CYCLES) {
+        slot.num_cycles = CYCLES_NOT_STORED;
+        return;
+    }
+    for (size_t c = 0; c < cycles.size(); c++) {
+        int nodes[PackedLoop::LENGTH], mapped[PackedLoop::LENGTH], slide;
+        Placement placement;
+        get_nodes(cycles[c], nodes);
+        map_loop(nodes, 0, t, false, mapped, slide, placement);
+        for (int i = 0; i < PackedLoop::LENGTH; i++)
+            slot.cycles[c][i] = mapped[i];
+        slot.infeasible[c] = 0;
+    }
+    slot.num_cycles = cycles.size();
+}
+
+vector<PackedLoop> ResultCache::load_cycles(const Slot &slot, int t) {
+    vector<PackedLoop> cycles(slot.num_cycles);
+    for (int c = 0; c < slot.num_cycles; c++) {
+        int nodes[PackedLoop::LENGTH], mapped[PackedLoop::LENGTH], slide;
+        Placement placement;
+        copy(slot.cycles[c], slot.cycles[c] + PackedLoop::LENGTH, nodes);
+        map_loop(nodes, 0, t, true, mapped, slide, placement);
+        cycles[c] = to_loop(mapped);
+    }
+    return cycles;
+}
+
+unsigned int ResultCache::infeasible_slides(const Slot &slot, int c,
+                                            const PackedLoop &cycle, int t) {
+    int nodes[PackedLoop::LENGTH], mapped[PackedLoop::LENGTH];
+    get_nodes(cycle, nodes);
+    unsigned int slides = 0;
+    for (int j = 0; j < 8; j++) {
+        int s;
+        Placement placement;
+        map_loop(nodes, j, t, false, mapped, s, placement);
+        if ((slot.infeasible[c] >> s) & 1)
+            slides |= 1u << j;
+    }
+    return slides;
+}
+
+void ResultCache::mark_infeasible(Slot &slot, int c, const PackedLoop &cycle,
+                                  int slide, int t) {
+    int nodes[PackedLoop::LENGTH], mapped[PackedLoop::LENGTH], s;
+    Placement placement;
+    get_nodes(cycle, nodes);
+    map_loop(nodes, slide, t, false, mapped, s, placement);
+    slot.infeasible[c] |= 1 << s;
+}
+
+static array<int, 49> cpstr_to_tiles(const string &cpstr) {
+    array<int, 49> tiles;
+    for (int cell = 0; cell < 49; cell++)
+        tiles[cell] = stoi(cpstr.substr(cell * 2, 2));
+    return tiles;
+}
+
+static string tiles_to_cpstr(const array<int, 49> &tiles) {
+    string cpstr;
+    for (int cell = 0; cell < 49; cell++) {
+        int tile = tiles[cell];
+        cpstr += (tile < 10 ? "0" : "") + to_string(tile);
+    }
+    return cpstr;
+}
+
+void ResultCache::store_cp(Slot &slot, const Solution &solution, int t) {
+    int nodes[PackedLoop::LENGTH], mapped[PackedLoop::LENGTH], slide;
+    Placement placement;
+    get_nodes(solution.loop, nodes);
+    map_loop(nodes, solution.slide, t, false, mapped, slide, placement);
+
+    array<int, 32> folds = solution.folds;
+    array<int, 49> tiles = cpstr_to_tiles(solution.cpstr);
+    array<int, 4> corners = solution.corners;
+    place(placement, folds, tiles, corners);
+
+    int m = is_mirror(t);
+    Found &found = slot.found[m];
+    found.cycle = solution.cycle;
+    found.slide = slide;
+    for (int i = 0; i < 32; i++) {
+        found.loop[i] = mapped[i];
+        found.folds[i] = folds[i];
+    }
+    for (int k = 0; k < 4; k++)
+        found.corners[k] = corners[k];
+    for (int cell = 0; cell < 49; cell++)
+        found.tiles[cell] = tiles[cell];
+    // 展開図を書き終えてから見つかったことにする
+    slot.found_mask |= 1 << m;
+    slot.state = FOUND;
+}
+
+bool ResultCache::load_cp(const Slot &slot, int t, Solution &solution) {
+    int m = is_mirror(t);
+    bool same = (slot.found_mask >> m) & 1;
+    const Found &found = slot.found[same ? m : 1 - m];
+
+    int nodes[PackedLoop::LENGTH], mapped[PackedLoop::LENGTH];
+    Placement placement;
+    copy(found.loop, found.loop + PackedLoop::LENGTH, nodes);
+    map_loop(nodes, found.slide, t, true, mapped, solution.slide, placement);
+    solution.cycle = found.cycle;
+    solution.loop = to_loop(mapped);
+    if (!same)
+        return false;
+
+    array<int, 49> tiles;
+    for (int i = 0; i < 32; i++)
+        solution.folds[i] = found.folds[i];
+    for (int k = 0; k < 4; k++)
+        solution.corners[k] = found.corners[k];
+    for (int cell = 0; cell < 49; cell++)
+        tiles[cell] = found.tiles[cell];
+    place(placement, solution.folds, tiles, solution.corners);
+    solution.cpstr = tiles_to_cpstr(tiles);
+    return true;
+}
+
+// 表のファイルの場所（実行ファイルと同じフォルダ）
+string GetResultCachePath() { return GetExeDirectory() + "result_cache.bin"; }
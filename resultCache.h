@@ -0,0 +1,137 @@
+#pragma once
+
+#include "packedLoop.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ドット絵ごとの探索結果を保存しておき、同じドット絵を何度も探さないための表
+//
+// ドット絵を64bitのビット列にし、8通りの回転・反転のうち最小のもの（正規形）を
+// キーにして、回転・反転したドット絵で結果を共有する
+// 展開図と4隅のほかに、探索の途中の結果として
+//   - 時計回りのループ
+//   - ループとずらしの組ごとに、平坦折り不可能と分かったもの
+//   - 展開図を作った折り割り当て
+// も持つので、途中で止めた探索は続きから再開できる
+//
+// 表の中身はすべて正規形のドット絵の向きで持ち、読み書きのたびに
+// クエリのドット絵の向きに移す。ドット絵を回転・反転すると、ループも同じように
+// 移り、展開図は外周の頂点の対応がずれる分だけ正方形ごと回転・反転する
+// ループの先頭は BoundaryGraph と同じく最も左（その中で最も上）の頂点にそろえるので、
+// 移した展開図はクエリのドット絵のループとずらしから作られたものになる
+// ただし折り割り当ては同値なものから1つを選んで生成している（"34", "36" を除く）ので、
+// 反転すると選ばれない方に移ることがある。そこで展開図は、正規形に移すのに
+// 反転を含むクエリと含まないクエリで別々に持ち、無い方はループとずらしだけを
+// 移して解き直す
+//
+// 表はファイルに置いた開番地法のハッシュ表で、mmap して直接読み書きする
+// ファイルは最初に引いたときに開く
+class ResultCache {
+  public:
+    static const int MAX_CYCLES = 16; // 保存するループの数の上限
+    static const std::uint8_t CYCLES_NOT_STORED = 0xff;
+
+    enum State : std::uint8_t { EMPTY = 0, SEARCHING = 1, FOUND = 2, NO_CP = 3 };
+
+    // 見つけた展開図（正規形の向き）
+    struct Found {
+        std::uint8_t cycle;      // 展開図を作ったループとずらし
+        std::uint8_t slide;
+        std::uint8_t corners[4]; // 4隅の辺
+        std::uint8_t tiles[49];  // 展開図のタイル番号
+        std::int8_t folds[32];   // 展開図を作った折り割り当て
+        std::uint8_t loop[32];   // 展開図を作ったループの頂点番号
+    };
+
+    // ファイル上の1項目
+    struct Slot {
+        std::uint64_t key;          // 正規形のビット列（0 は空き）
+        std::uint8_t state;         // State
+        std::uint8_t num_cycles;    // 保存したループの数（CYCLES_NOT_STORED なら無し）
+        std::uint8_t found_mask;    // bit m : found[m] がある
+        Found found[2];             // 反転を含まない / 含むクエリで見つけた展開図
+        std::uint8_t infeasible[MAX_CYCLES];  // bit j : rotated(j) が平坦折り不可能
+        std::uint8_t cycles[MAX_CYCLES][32];  // ループの頂点番号
+    };
+
+    // 見つけた展開図と、それを作ったループ・ずらし・折り割り当て
+    struct Solution {
+        int cycle = 0;
+        int slide = 0;
+        PackedLoop loop; // ずらす前のループ
+        std::array<int, 32> folds;
+        std::string cpstr;
+        std::array<int, 4> corners;
+    };
+
+  private:
+    std::string path;
+    bool opened = false;
+    std::uint32_t *header = nullptr; // MAGIC, 容量, 項目数, 予約
+    Slot *slots = nullptr;
+    void *mapped = nullptr;
+    std::size_t mapped_size = 0;
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+    bool map(std::uint32_t capacity);
+    void unmap();
+    bool ensure_open();
+    bool grow();
+    Slot *probe(std::uint64_t key) const;
+
+    // 展開図の移し方：mirror なら左右反転してから、時計回りに quarter 回 90度回す
+    struct Placement {
+        bool mirror;
+        int quarter;
+    };
+    static void map_loop(const int *nodes, int slide, int t, bool inverse,
+                         int *mapped, int &mapped_slide, Placement &placement);
+    static void place(const Placement &placement, std::array<int, 32> &folds,
+                      std::array<int, 49> &tiles, std::array<int, 4> &corners);
+
+  public:
+    explicit ResultCache(const std::string &path);
+    ~ResultCache();
+    ResultCache(const ResultCache &) = delete;
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    // 8通りの回転・反転のうち最小のビット列（bit y * 8 + x がマス (x, y)）
+    // t にはドット絵を正規形に移す回転・反転（0..7）を返す
+    static std::uint64_t canonical_key(const std::vector<std::vector<int>> &grid,
+                                       int &t);
+
+    // 無ければ nullptr
+    Slot *find(std::uint64_t key);
+
+    // 無ければ作る。ファイルが使えなければ nullptr
+    // 表を広げることがあるので、それまでに得た Slot は使えなくなる
+    Slot *insert(std::uint64_t key);
+
+    // 以下の t は canonical_key で得たクエリの回転・反転
+    // ループやずらし、展開図はクエリの向きで受け渡す
+    static void store_cycles(Slot &slot, const std::vector<PackedLoop> &cycles,
+                             int t);
+    static std::vector<PackedLoop> load_cycles(const Slot &slot, int t);
+
+    // ループ cycle（番号 c）のずらしのうち、平坦折り不可能と分かっているもの
+    static unsigned int infeasible_slides(const Slot &slot, int c,
+                                          const PackedLoop &cycle, int t);
+    static void mark_infeasible(Slot &slot, int c, const PackedLoop &cycle,
+                                int slide, int t);
+
+    static void store_cp(Slot &slot, const Solution &solution, int t);
+
+    // t と同じ反転の有無で見つけた展開図があれば、solution に移して true を返す
+    // 無ければ、もう一方の展開図のループとずらし（cycle, slide, loop）だけを移して
+    // false を返す。そのループは平坦折り可能なので、解き直せば展開図が得られる
+    static bool load_cp(const Slot &slot, int t, Solution &solution);
+};
+
+std::string GetResultCachePath();
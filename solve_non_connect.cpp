@@ -1,301 +1,32 @@
 #include <iostream>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <string>
-#include <stack>
-#include <map>
 #include <array>
 
 #include "boundary_extractor.hpp"
+#include "EulerSolver.hpp"
+#include "DetourSearch.hpp"
+#include "PathFilter.hpp"
+#include "FoldGenerator.hpp"
 #include "foldsToEdges.h"
 #include "ftcp.h"
+#include "foldNogood.h"
+#include "interiorOracle.h"
+#include "foldPrefilter.h"
+#include "packedLoop.h"
 
 using namespace std;
 
-#define FRONT 1
-#define BACK 0
-
-#define L (-1)
-#define S 0
-#define R 1
-#define X 2
-
-char FOLD_DIR[8] = {S, R, X, R, L, X, R, X};
-int FOLD_FLIP[8] = {0, 1, 1, 0, 1, 0, 0, 1};
-
-using Node = int;
-using Path = std::vector<Node>;
-using FoldAssignment = std::vector<int>;
-
-////////////////////////////////////////////////////////////
-// --- 折り割当関係 ---
-
-enum class Shape
-{
-    RIGHT,
-    LEFT,
-    STRAIGHT,
-};
-
-Shape get_shape(Node prev, Node curr, Node next)
-{
-    int dx1 = (curr % 9) - (prev % 9);
-    int dy1 = (curr / 9) - (prev / 9);
-    int dx2 = (next % 9) - (curr % 9);
-    int dy2 = (next / 9) - (curr / 9);
-
-    // ベクトル1: prev -> curr
-    // ベクトル2: curr -> next
-    int cross_product = dx1 * dy2 - dy1 * dx2;
-
-    if (cross_product > 0)
-    {
-        return Shape::RIGHT;
-    }
-    else if (cross_product < 0)
-    {
-        return Shape::LEFT;
-    }
-    else
-    {
-        return Shape::STRAIGHT;
-    }
-}
-
-string shape_to_string(Shape s)
-{
-    switch (s)
-    {
-    case Shape::RIGHT:
-        return "R";
-    case Shape::LEFT:
-        return "L";
-    case Shape::STRAIGHT:
-        return "S";
-    default:
-        return "X";
-    }
-}
-
-string path_to_shape_string(const Path &path)
-{
-    stringstream ss;
-    for (int i = 0; i < 32; i++)
-    {
-        Node prev = path[(i + 31) % 32];
-        Node curr = path[i];
-        Node next = path[(i + 1) % 32];
-        Shape s = get_shape(prev, curr, next);
-        ss << shape_to_string(s);
-    }
-    return ss.str();
-}
-
-vector<vector<int>> NG_LIST = {
-    {0, 8, 4},
-    {0, 8, 6},
-    {4, 8, 4},
-    {4, 8, 6},
-    {6, 8, 4},
-    {6, 8, 6},
-    {1, 8, 0},
-    {1, 8, 1},
-    {1, 8, 3},
-    {3, 8, 0},
-    {3, 8, 1},
-    {3, 8, 3},
-    {3, 4},
-    {3, 6}};
-
-bool has_NG_words(vector<int> v)
-{
-    if (v.size() == 32)
-    {
-        v.push_back(v[0]);
-    }
-
-    for (auto ng : NG_LIST)
-    {
-        if (v.size() < ng.size())
-            continue;
-
-        bool flag = true;
-        for (int i = 0; i < ng.size(); i++)
-        {
-            int n = ng[ng.size() - 1 - i];
-            int m = v[v.size() - 1 - i];
-            if (m != n)
-            {
-                flag = false;
-                break;
-            }
-        }
-        if (flag)
-            return true;
-    }
-
-    return false;
-}
-
-vector<int> toInt(string s)
-{
-    map<char, int> ctoi = {{'S', S}, {'R', R}, {'L', L}, {'X', X}};
-    vector<int> ans;
-    for (char c : s)
-        ans.push_back(ctoi.at(c));
-    return ans;
-}
-
-// LRS形式から折り割当に変換する関数
-vector<vector<int>> LRtoNum2(string input_str)
-{
-
-    // 8の倍数番目の文字がSなら不適
-    if (input_str[0] == 'S' || input_str[8] == 'S' || input_str[16] == 'S' || input_str[24] == 'S')
-        return vector<vector<int>>();
-
-    // LRSからなる入力文字列を-1,0,1の列に変換
-    vector<int> lrint = toInt(input_str);
-
-    // ここでは配列のインデックスとして使いたいため1を加算
-    for (int i = 0; i < lrint.size(); i++)
-    {
-        lrint[i] += 1;
-    }
-
-    // 紙の表裏を決定
-    int side = (lrint[0] == R + 1) ? FRONT : BACK;
-
-    // 向きと折り番号の対応
-    vector<int> fold_table[2][3];
-    fold_table[FRONT][S + 1] = {0};
-    fold_table[FRONT][L + 1] = {4};
-    fold_table[FRONT][R + 1] = {1, 3, 6};
-    fold_table[BACK][S + 1] = {0};
-    fold_table[BACK][R + 1] = {4};
-    fold_table[BACK][L + 1] = {1, 3, 6};
-
-    // 表裏が入れ替わるかどうか
-    map<int, int> flip_map;
-    flip_map[0] = 0; // 折り方0番は裏返らない
-    flip_map[1] = 1;
-    flip_map[3] = 0;
-    flip_map[4] = 1;
-    flip_map[6] = 0;
-    flip_map[8] = 0;
-
-    // --- NGリスト ---
-    // "084", "086", "484", "486", "684", "686",
-    // "180", "181", "183", "380", "381", "383" : 折れない
-    // "34", "36" : 折れるが同値な折り方が存在する
-
-    // --- 探索処理 ---
-
-    vector<vector<int>> answers;
-
-    struct Node
-    {
-        int side;
-        vector<int> folds;
-    };
-
-    stack<Node> stk;
-    stk.push({side, {}});
-
-    while (!stk.empty())
-    {
-        Node node = stk.top();
-        stk.pop();
-
-        // 終了処理
-        if (node.folds.size() == 32)
-        {
-            if (has_NG_words(node.folds))
-                continue;
-
-            answers.push_back(node.folds);
-            continue;
-        }
-
-        // 8の倍数の処理
-        if (node.folds.size() % 8 == 0)
-        {
-            int lr = lrint[node.folds.size()];
-            if (node.side == BACK && lr == R + 1)
-                continue;
-            if (node.side == FRONT && lr == L + 1)
-                continue;
-
-            node.folds.push_back(8);
-            stk.push(node);
-            continue;
-        }
-
-        // 一般の処理
-
-        for (auto f : fold_table[node.side][lrint[node.folds.size()]])
-        {
-            vector<int> new_folds = node.folds;
-            new_folds.push_back(f);
-
-            if (has_NG_words(new_folds))
-                continue;
-
-            stk.push({(node.side + flip_map[f]) % 2, new_folds});
-        }
-    }
-
-    return answers;
-}
-
-vector<FoldAssignment> generate_fold_assignments(string dirctory)
-{
-    // データの読み込み
-    cout << "load " << dirctory << endl;
-    ifstream ifs(dirctory);
-    string line;
-    vector<Path> paths;
-    while (getline(ifs, line))
-    {
-        stringstream ss(line);
-        Path path;
-        int node;
-        while (ss >> node)
-        {
-            path.push_back(node);
-        }
-        if (!path.empty())
-            paths.push_back(path);
-    }
-    ifs.close();
-
-    // 方向文字列形式に変換
-    vector<string> shape_strings;
-    for (Path path : paths)
-    {
-        string shape_string = path_to_shape_string(path);
-        shape_strings.push_back(shape_string);
-    }
-
-    // 折り割当形式を生成
-    vector<vector<int>> all_folds;
-    for (string shape_string : shape_strings)
-    {
-        vector<vector<int>> folds = LRtoNum2(shape_string);
-        all_folds.insert(all_folds.end(), folds.begin(), folds.end());
-    }
-
-    // 出力テスト
-    cout << all_folds.size() << " fold assingments found." << endl;
-
-    return all_folds;
-}
-
 ////////////////////////////////////////////////////////////////////////////////////
 
 void searchCP(vector<FoldAssignment> fold_assignments, string &cp, string &four_corners)
 {
+    Counter c(7);
+    FoldPrefilter prefilter;
+    FoldNogood nogood;
+    InteriorOracle oracle;
+    oracle.load_or_build(GetOraclePath());
+
     for (FoldAssignment fold_assignment : fold_assignments)
     {
 
@@ -303,8 +34,21 @@ void searchCP(vector<FoldAssignment> fold_assignments, string &cp, string &four_
         array<int, 32> fold_array;
         std::copy(fold_assignment.begin(), fold_assignment.end(), fold_array.begin());
 
+        // 局所的に矛盾する折り割り当てはDPにかけない
+        if (!prefilter.check(fold_array))
+            continue;
+
+        // 以前に失敗した部分割り当てを含むものもDPにかけない
+        if (nogood.contains(fold_array))
+            continue;
+
         // CPの探索
-        cp = folds_to_cpstr(fold_array);
+        array<uint64_t, 49> domain = create_tile_domain_by_folds(fold_array);
+        cp = "No CP";
+        if (oracle.has_cp(domain))
+            cp = c.domain_to_cpstr(domain);
+        else
+            nogood.learn(c, fold_array, oracle.get_dead_cell());
 
         if (cp != "No CP")
         {
@@ -320,47 +64,81 @@ void searchCP(vector<FoldAssignment> fold_assignments, string &cp, string &four_
             }
             four_corners = cornersstr;
 
+            prefilter.print_stats("");
+            nogood.print_stats("");
             return;
         }
     }
+
+    prefilter.print_stats("");
+    nogood.print_stats("");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// 歩き方を条件を満たす回転にそろえ、折り割当を作ってCPを探す
+void solveWalks(const vector<vector<Node>> &walks, string &cp, string &four_corners)
+{
+    // 条件を満たす最初の回転にそろえる
+    PathFilter path_filter;
+    path_filter.load_path(walks);
+    if (path_filter.get_skipped_count() > 0)
+        cout << "Skipped " << path_filter.get_skipped_count()
+             << " walks that are not 32 steps." << endl;
+    path_filter.filter();
+    cout << "Results: " << path_filter.get_filtered_paths().size() << " / "
+         << path_filter.get_all_paths().size() << " paths matched." << endl;
+
+    // 折り割当の生成
+    vector<FoldAssignment> fold_assignments = FoldGenerator::generate(path_filter.get_filtered_paths());
+    cout << fold_assignments.size() << " fold assingments found." << endl;
+
+    // CPの探索
+    searchCP(fold_assignments, cp, four_corners);
+}
+
 ///////////////////////////////////////////////////////////////////////////
 
 /// @brief ///////////////////////////////////////////////////////////////
 /// @param argc
-/// @param argv 64文字からなるドット絵
+/// @param argv 64文字からなるドット絵（-detour を付けると遠回りのループも探す）
 /// @return //
 int main(int argc, char *argv[])
 {
     // バリデーション
-    if (argc != 2)
+    bool detour = argc == 3 && string(argv[2]) == "-detour";
+    if (argc != 2 && !detour)
     {
-        std::cerr << "Usage: " << argv[0] << " <dotstr>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <dotstr> [-detour]" << std::endl;
         return 1;
     }
 
     // ドット絵の読み込み
+    // 境界の抽出からCPの探索までを、ファイルを介さずにこのプロセスの中で行う
     string dotstr = argv[1];
-    BoundaryExtractor be;
-    be.save_as_edges(dotstr, "edges.txt");
+    EdgeList edges = BoundaryExtractor::extract_pairs(dotstr);
+    cout << "Loaded " << edges.size() << " edges" << endl;
 
     // 各境界線を通る閉路を計算
-    string cmd = ".\\shortest_euler_walk.exe edges.txt solutions.txt";
-    system(cmd.c_str());
-
-    // 前処理で枝刈り
-    string cmd2 = ".\\path_filter.exe solutions.txt filtered_solutions.txt";
-    system(cmd2.c_str());
+    // path_filter の条件は探索の途中で判定し、満たさない歩き方は作らない
+    int skipped = 0;
+    vector<vector<Node>> walks = find_shortest_walks(edges, WalkConstraints::loop_filter(), &skipped);
+    cout << "Found " << walks.size() << " shortest walks." << endl;
+    // 最短の歩き方が32歩でなければ、外周のループにはならないので探さない
+    if (skipped > 0)
+        cout << "Skipped " << skipped << " edge patterns whose walks are not 32 steps." << endl;
 
-    // 折り割当の生成
-    vector<FoldAssignment> fold_assignments = generate_fold_assignments("filtered_solutions.txt");
-
-    // CPの探索
     string cp = "", four_corners = "";
-    searchCP(fold_assignments, cp, four_corners);
+    solveWalks(walks, cp, four_corners);
+
+    // 最短の歩き方で折れなければ、遠回りした32歩のループを探す
+    if (detour && (cp == "" || cp == "No CP"))
+    {
+        DetourSearch detour_search;
+        walks = detour_search.search(edges);
+        cout << "Found " << walks.size() << " detour walks." << endl;
+        solveWalks(walks, cp, four_corners);
+    }
 
     // 結果の出力
     cout << "CPSTR:" << cp << endl;
@@ -0,0 +1,122 @@
+#pragma once
+
+// 折り割り当てから各内部頂点に置けるタイルの集合を直接求めるための表
+// タイルの集合は36bitのマスク（bit t がタイル t を置けることを表す）で表す
+// 表はすべてコンパイル時に計算する
+
+#include <array>
+#include <cstdint>
+
+constexpr int TILE[36][8] = {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 1, 0, 0, 0, 1},
+                             {0, 0, 1, 0, 0, 0, 1, 0}, {0, 0, 1, 0, 0, 1, 1, 1},
+                             {0, 0, 1, 0, 1, 1, 0, 1}, {0, 0, 1, 1, 1, 0, 0, 1},
+                             {0, 1, 0, 0, 0, 1, 0, 0}, {0, 1, 0, 0, 1, 0, 1, 1},
+                             {0, 1, 0, 0, 1, 1, 1, 0}, {0, 1, 0, 1, 0, 1, 0, 1},
+                             {0, 1, 0, 1, 1, 0, 1, 0}, {0, 1, 0, 1, 1, 1, 1, 1},
+                             {0, 1, 1, 0, 1, 0, 0, 1}, {0, 1, 1, 1, 0, 0, 1, 0},
+                             {0, 1, 1, 1, 0, 1, 1, 1}, {0, 1, 1, 1, 1, 1, 0, 1},
+                             {1, 0, 0, 0, 1, 0, 0, 0}, {1, 0, 0, 1, 0, 0, 1, 1},
+                             {1, 0, 0, 1, 0, 1, 1, 0}, {1, 0, 0, 1, 1, 1, 0, 0},
+                             {1, 0, 1, 0, 0, 1, 0, 1}, {1, 0, 1, 0, 1, 0, 1, 0},
+                             {1, 0, 1, 0, 1, 1, 1, 1}, {1, 0, 1, 1, 0, 1, 0, 0},
+                             {1, 0, 1, 1, 1, 0, 1, 1}, {1, 0, 1, 1, 1, 1, 1, 0},
+                             {1, 1, 0, 0, 1, 0, 0, 1}, {1, 1, 0, 1, 0, 0, 1, 0},
+                             {1, 1, 0, 1, 0, 1, 1, 1}, {1, 1, 0, 1, 1, 1, 0, 1},
+                             {1, 1, 1, 0, 0, 1, 0, 0}, {1, 1, 1, 0, 1, 0, 1, 1},
+                             {1, 1, 1, 0, 1, 1, 1, 0}, {1, 1, 1, 1, 0, 1, 0, 1},
+                             {1, 1, 1, 1, 1, 0, 1, 0}, {1, 1, 1, 1, 1, 1, 1, 1}};
+
+// 外周頂点（カド以外）に現れる折り方とその番号
+constexpr int FOLD_VALUES[5] = {0, 1, 3, 4, 6};
+constexpr int FOLD_CODE[9] = {0, 1, -1, 2, 3, -1, 4, -1, -1};
+
+// すべてのタイルを置ける状態
+constexpr std::uint64_t ALL_TILES = (1ULL << 36) - 1;
+
+// DIR_TILE_MASK[d][v] : 方向 d の辺の値が v であるタイルの集合
+struct DirTileMask {
+    std::uint64_t mask[8][2];
+};
+
+constexpr DirTileMask make_dir_tile_mask() {
+    DirTileMask t{};
+    for (int d = 0; d < 8; d++) {
+        for (int tile = 0; tile < 36; tile++) {
+            t.mask[d][TILE[tile][d]] |= 1ULL << tile;
+        }
+    }
+    return t;
+}
+
+constexpr DirTileMask DIR_TILE_MASK = make_dir_tile_mask();
+
+// 外周頂点から延びる辺によって、内部頂点のタイルがどう制限されるか
+// cell[out][j]    : 外周頂点 out の j 番目の辺の先にある内部頂点（無ければ -1）
+// mask[out][f][j] : 外周頂点 out の折り方が f のとき、cell[out][j] に置けるタイル
+struct FoldTileMask {
+    int cell[32][3];
+    std::uint64_t mask[32][9][3];
+};
+
+constexpr FoldTileMask make_fold_tile_mask() {
+    // foldsToEdges.cpp の get_edge_dirrection_of_outer_vertex と同じ対応
+    // (LOWER_RIGHT, DOWN, LOWER_LEFT), (LOWER_LEFT, LEFT, UPPER_LEFT), ...
+    const int OUTER_DIR[4][3] = {{3, 4, 5}, {5, 6, 7}, {7, 0, 1}, {1, 2, 3}};
+    const int DX[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    const int DY[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+    FoldTileMask t{};
+    for (int out = 0; out < 32; out++) {
+        int pos = out / 8;
+        int mod = out % 8;
+
+        // 外周頂点の座標
+        int x = 0, y = 0;
+        if (pos == 0)
+            x = mod, y = 0;
+        else if (pos == 1)
+            x = 8, y = mod;
+        else if (pos == 2)
+            x = 8 - mod, y = 8;
+        else
+            x = 0, y = 8 - mod;
+
+        for (int j = 0; j < 3; j++) {
+            int dout = OUTER_DIR[pos][j];
+            int ix = x - 1 + DX[dout];
+            int iy = y - 1 + DY[dout];
+
+            // カドの頂点には折り線が無い
+            bool valid = mod != 0 && 0 <= ix && ix <= 6 && 0 <= iy && iy <= 6;
+            t.cell[out][j] = valid ? ix + iy * 7 : -1;
+
+            // 内部頂点から見た外周頂点の方向
+            int d = (dout + 4) % 8;
+            for (int f = 0; f < 9; f++) {
+                int e = (f >> j) % 2;
+                t.mask[out][f][j] =
+                    valid ? DIR_TILE_MASK.mask[d][e] : ALL_TILES;
+            }
+        }
+    }
+    return t;
+}
+
+constexpr FoldTileMask FOLD_TILE_MASK = make_fold_tile_mask();
+
+// 90度のカドを45度にするような折りをしない
+// (内部頂点, 方向) = (0, UPPER_LEFT), (6, UPPER_RIGHT), (42, LOWER_LEFT),
+// (48, LOWER_RIGHT) の辺は折らない
+constexpr std::array<std::uint64_t, 49> make_base_tile_domain() {
+    std::array<std::uint64_t, 49> domain{};
+    for (int cell = 0; cell < 49; cell++)
+        domain[cell] = ALL_TILES;
+    domain[0] &= DIR_TILE_MASK.mask[7][0];
+    domain[6] &= DIR_TILE_MASK.mask[1][0];
+    domain[42] &= DIR_TILE_MASK.mask[5][0];
+    domain[48] &= DIR_TILE_MASK.mask[3][0];
+    return domain;
+}
+
+constexpr std::array<std::uint64_t, 49> BASE_TILE_DOMAIN =
+    make_base_tile_domain();